@@ -0,0 +1,113 @@
+#ifndef CHRISTMAS_CLOCK_BENCHMARK_H
+#define CHRISTMAS_CLOCK_BENCHMARK_H
+
+#include <Arduino.h> // micros(), Print
+
+/**
+ * Accumulates the micros() taken by repeated calls of a single operation, and
+ * prints the average as one CSV line of the form
+ * "{app},{mode},{op},{iterations},{per_op}", for example:
+ *
+ * @code
+ * app,mode,op,iterations,per_op
+ * ChristmasClock,1,update,100,41230
+ * ChristmasClock,1,updateBlinkState,100,650
+ * ChristmasClock,1,updateDisplay,100,310
+ * @endcode
+ *
+ * The per_op of a timed operation is in nanoseconds, calculated from micros(),
+ * so the resolution is 1 us on EpoxyDuino, and 4 us on a 16 MHz AVR. Other
+ * counters (e.g. the display bus traffic) use printLineTo() with their own
+ * unit per iteration.
+ */
+class BenchmarkTimer {
+  public:
+    /** Print the header line of the CSV output. */
+    static void printHeaderTo(Print& printer) {
+      printer.println(F("app,mode,op,iterations,per_op"));
+    }
+
+    /** Print one CSV line. */
+    static void printLineTo(Print& printer, const __FlashStringHelper* app,
+        uint8_t mode, const __FlashStringHelper* op, uint16_t iterations,
+        uint32_t perOp) {
+      printer.print(app);
+      printer.print(',');
+      printer.print(mode);
+      printer.print(',');
+      printer.print(op);
+      printer.print(',');
+      printer.print(iterations);
+      printer.print(',');
+      printer.println(perOp);
+    }
+
+    void start() {
+      mStartMicros = micros();
+    }
+
+    void stop() {
+      mElapsedMicros += micros() - mStartMicros;
+      mCount++;
+    }
+
+    /** Print the CSV line of the operation, then reset the timer. */
+    void printTo(Print& printer, const __FlashStringHelper* app, uint8_t mode,
+        const __FlashStringHelper* op) {
+      printLineTo(printer, app, mode, op, mCount, nanosPerOp());
+
+      mElapsedMicros = 0;
+      mCount = 0;
+    }
+
+  private:
+    /** Average nanos, without overflowing 32 bits for up to 4.2 s. */
+    uint32_t nanosPerOp() const {
+      if (mCount == 0) return 0;
+      return mElapsedMicros / mCount * 1000
+          + mElapsedMicros % mCount * 1000 / mCount;
+    }
+
+    uint32_t mStartMicros = 0;
+    uint32_t mElapsedMicros = 0;
+    uint16_t mCount = 0;
+};
+
+/**
+ * Visit each view Mode of the Controller using its Mode button, and each
+ * change Mode reachable from it by a long press, until the Mode button returns
+ * to the first Mode, or until maxModes Modes were visited. The benchmarkMode()
+ * function is called in each Mode, with isViewMode set in the view Modes.
+ * Return the number of Modes visited.
+ *
+ * The long press which leaves a change Mode saves the changing clock info,
+ * which sets the clock and marks the StoredInfo as dirty, so the caller must
+ * restore them afterwards.
+ */
+template <typename T_CONTROLLER>
+uint8_t benchmarkModes(T_CONTROLLER& controller,
+    void (*benchmarkMode)(bool isViewMode), uint8_t maxModes) {
+  uint8_t numModes = 0;
+  uint8_t firstViewMode = (uint8_t) controller.getMode();
+  do {
+    benchmarkMode(true /*isViewMode*/);
+    numModes++;
+    uint8_t viewMode = (uint8_t) controller.getMode();
+    controller.handleModeButtonLongPress();
+    uint8_t firstChangeMode = (uint8_t) controller.getMode();
+    if (firstChangeMode != viewMode) {
+      do {
+        benchmarkMode(false /*isViewMode*/);
+        numModes++;
+        controller.handleModeButtonPress();
+      } while ((uint8_t) controller.getMode() != firstChangeMode
+          && numModes < maxModes);
+      controller.handleModeButtonLongPress();
+    }
+    controller.handleModeButtonPress();
+  } while ((uint8_t) controller.getMode() != firstViewMode
+      && numModes < maxModes);
+  return numModes;
+}
+
+#endif
@@ -18,6 +18,8 @@ hardware:
 #include <AceTimeClock.h>
 #include "PersistentStore.h"
 #include "Controller.h"
+#include "Benchmark.h"
+#include "SyncPolicy.h"
 
 using namespace ace_segment;
 using namespace ace_button;
@@ -31,7 +33,8 @@ using namespace ace_wire;
 // Configure PersistentStore
 //------------------------------------------------------------------
 
-const uint32_t kContextId = 0x34ce0b3e; // random contextId
+// Random contextId, changed whenever the layout of the StoredInfo changes.
+const uint32_t kContextId = 0x44f434ef;
 const uint16_t kStoredInfoEepromAddress = 0;
 
 PersistentStore persistentStore(kContextId, kStoredInfoEepromAddress);
@@ -138,7 +141,29 @@ const TimeZoneData DISPLAY_ZONE = {zonedb::kZoneIdAmerica_Los_Angeles};
   #error Unknown BACKUP_TIME_SOURCE_TYPE
 #endif
 
-SYSTEM_CLOCK systemClock(refClock, backupClock, 60 /*syncPeriod*/);
+// The SyncPolicy forces each sync with a blocking read of the reference clock,
+// which would stall loop() for up to the request timeout of the NtpClock. So
+// an NTP build keeps the fixed SYNC_PERIOD_MIN_SECONDS of the systemClock,
+// whose coroutine syncs without blocking. Without a reference clock, there is
+// nothing to sync with.
+#if TIME_SOURCE_TYPE == TIME_SOURCE_TYPE_NONE \
+    || TIME_SOURCE_TYPE == TIME_SOURCE_TYPE_NTP
+  #define ENABLE_SYNC_POLICY 0
+  #define SYSTEM_CLOCK_SYNC_SECONDS SYNC_PERIOD_MIN_SECONDS
+#else
+  #define ENABLE_SYNC_POLICY 1
+  #define SYSTEM_CLOCK_SYNC_SECONDS SYNC_PERIOD_MAX_SECONDS
+#endif
+
+SYSTEM_CLOCK systemClock(
+    refClock, backupClock, SYSTEM_CLOCK_SYNC_SECONDS /*syncPeriod*/);
+
+#if ENABLE_SYNC_POLICY
+// Syncs the systemClock as often as its measured drift requires, between
+// SYNC_PERIOD_MIN_SECONDS and the SYNC_PERIOD_MAX_SECONDS of the systemClock.
+SyncPolicy syncPolicy(systemClock, SYNC_PERIOD_MIN_SECONDS,
+    SYNC_PERIOD_MAX_SECONDS, SYNC_SKEW_BOUND_SECONDS);
+#endif
 
 void setupClocks() {
 #if TIME_SOURCE_TYPE == TIME_SOURCE_TYPE_DS3231 \
@@ -390,6 +415,79 @@ void setupWire() {
 #endif
 }
 
+//-----------------------------------------------------------------------------
+// Benchmark the Controller and the Presenter in each Mode.
+//-----------------------------------------------------------------------------
+
+#if ENABLE_BENCHMARK
+
+static const uint16_t BENCHMARK_ITERATIONS = 100;
+
+// Stop if the Mode button never cycles back to the first Mode.
+static const uint8_t BENCHMARK_MAX_MODES = 64;
+
+// Start of the clock in each Mode.
+static acetime_t benchmarkStartSeconds;
+
+// Time each operation BENCHMARK_ITERATIONS times in the current Mode, with the
+// SystemClock advanced by 1 second before each iteration.
+// The update is the Controller alone, and each render is timed by
+// updateDisplay, after both the update and the blink.
+void benchmarkMode(bool /*isViewMode*/) {
+  BenchmarkTimer updateTimer;
+  BenchmarkTimer blinkTimer;
+  BenchmarkTimer displayTimer;
+
+  for (uint16_t i = 0; i < BENCHMARK_ITERATIONS; ++i) {
+    systemClock.setNow(benchmarkStartSeconds + i);
+    updateTimer.start();
+    controller.updateClockInfo();
+    updateTimer.stop();
+    displayTimer.start();
+    presenter.updateDisplay();
+    displayTimer.stop();
+    blinkTimer.start();
+    controller.updateBlinkState();
+    blinkTimer.stop();
+    displayTimer.start();
+    presenter.updateDisplay();
+    displayTimer.stop();
+  }
+
+  uint8_t mode = (uint8_t) controller.getMode();
+  updateTimer.printTo(
+      SERIAL_PORT_MONITOR, F("ChristmasClock"), mode, F("update"));
+  blinkTimer.printTo(
+      SERIAL_PORT_MONITOR, F("ChristmasClock"), mode, F("updateBlinkState"));
+  displayTimer.printTo(
+      SERIAL_PORT_MONITOR, F("ChristmasClock"), mode, F("updateDisplay"));
+}
+
+// Benchmark each Mode, then restore the clock and the StoredInfo changed by
+// the walk through the Modes.
+void runBenchmark() {
+  benchmarkStartSeconds =
+      LocalDateTime::forComponents(2025, 1, 1, 0, 0, 0).toEpochSeconds();
+  acetime_t savedSeconds = systemClock.getNow();
+  uint32_t savedMillis = millis();
+  BenchmarkTimer::printHeaderTo(SERIAL_PORT_MONITOR);
+
+  benchmarkModes(controller, benchmarkMode, BENCHMARK_MAX_MODES);
+
+  // Restore the clock moved by the benchmark, and drop the StoredInfo saved
+  // when leaving each change Mode.
+  persistentStore.discard();
+  if (savedSeconds != LocalDateTime::kInvalidEpochSeconds) {
+    systemClock.setNow(savedSeconds + (millis() - savedMillis) / 1000);
+  }
+
+#if defined(EPOXY_DUINO)
+  exit(0);
+#endif
+}
+
+#endif
+
 //------------------------------------------------------------------
 // Main setup and loop
 //------------------------------------------------------------------
@@ -400,9 +498,11 @@ void setup() {
   // 1500ms needed for Wire, I2C or SSD1306 (don't know which one).
   delay(2000);
 
-#if ENABLE_SERIAL_DEBUG >= 1
+#if ENABLE_SERIAL_DEBUG >= 1 || ENABLE_BENCHMARK >= 1
   Serial.begin(115200); // ESP8266 default of 74880 not supported on Linux
   while (!Serial); // Wait until Serial is ready - Leonardo/Micro
+#endif
+#if ENABLE_SERIAL_DEBUG >= 1
   Serial.println(F("setup(): begin"));
 #endif
 
@@ -417,6 +517,10 @@ void setup() {
   setupAceSegment();
   controller.setup();
 
+#if ENABLE_BENCHMARK
+  runBenchmark();
+#endif
+
 #if ENABLE_SERIAL_DEBUG >= 1
   Serial.println(F("setup(): end"));
 #endif
@@ -427,10 +531,15 @@ void loop() {
   blinker.runCoroutine();
   updateClock.runCoroutine();
   renderLed.runCoroutine();
+  persistentStore.loop();
 
 #if SYSTEM_CLOCK_TYPE == SYSTEM_CLOCK_TYPE_LOOP
   systemClock.loop();
 #elif SYSTEM_CLOCK_TYPE == SYSTEM_CLOCK_TYPE_COROUTINE
   systemClock.runCoroutine();
 #endif
+
+#if ENABLE_SYNC_POLICY
+  syncPolicy.loop();
+#endif
 }
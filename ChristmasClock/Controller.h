@@ -7,6 +7,7 @@
 #include "config.h"
 #include "ClockInfo.h"
 #include "Presenter.h"
+#include "ZoneWindow.h"
 #include "StoredInfo.h"
 
 using namespace ace_segment;
@@ -67,14 +68,25 @@ class Controller {
       updateDateTime();
     }
 
+    /** Return the current Mode, used by the benchmark. */
+    Mode getMode() const { return mClockInfo.mode; }
+
+    /**
+     * Update the ClockInfo from the clock and pass it to the Presenter,
+     * without rendering the display.
+     */
+    void updateClockInfo() {
+      updateDateTime();
+      updatePresenter();
+    }
+
     /**
      * This should be called every 0.1s to avoid noticeable drift against the
      * RTC which has a 1 second resolution.
      */
     void update() {
       if (mClockInfo.mode == Mode::kUnknown) return;
-      updateDateTime();
-      updatePresenter();
+      updateClockInfo();
       mPresenter.updateDisplay();
     }
 
@@ -353,8 +365,13 @@ class Controller {
 
   private:
     void updateDateTime() {
-      TimeZone tz = mZoneManager.createForTimeZoneData(mClockInfo.timeZoneData);
-      mClockInfo.dateTime = ZonedDateTime::forEpochSeconds(mClock.getNow(), tz);
+      acetime_t nowSeconds = mClock.getNow();
+      const TimeZoneData& zoneData = mClockInfo.timeZoneData;
+      if (! mZoneWindow.isValid(nowSeconds, zoneData)) {
+        TimeZone tz = mZoneManager.createForTimeZoneData(zoneData);
+        mZoneWindow.reset(nowSeconds, zoneData, tz);
+      }
+      mClockInfo.dateTime = mZoneWindow.forEpochSeconds(nowSeconds);
 
       // If in CHANGE mode, and the 'second' field has not been cleared, update
       // the displayed time with the current second.
@@ -445,7 +462,7 @@ class Controller {
       }
       StoredInfo storedInfo;
       storedInfoFromClockInfo(storedInfo, clockInfo);
-      mPersistentStore.writeStoredInfo(storedInfo);
+      mPersistentStore.saveStoredInfo(storedInfo);
     }
 
     /** Convert ClockInfo to StoredInfo. */
@@ -478,6 +495,9 @@ class Controller {
     ExtendedZoneManager& mZoneManager;
   #endif
     TimeZoneData mInitialTimeZoneData;
+
+    // UTC offset of the time zone, valid until its next DST transition.
+    ZoneWindow mZoneWindow;
     uint16_t mZoneRegistryIndex;
 
     // LED brightness
@@ -0,0 +1,124 @@
+#ifndef CHRISTMAS_CLOCK_SYNC_POLICY_H
+#define CHRISTMAS_CLOCK_SYNC_POLICY_H
+
+#include <stdint.h>
+#include <AceTime.h> // acetime_t
+#include <AceTimeClock.h> // SystemClock
+
+/**
+ * Chooses when the SystemClock syncs with its reference clock, from the drift
+ * measured by the previous syncs, instead of a fixed period.
+ *
+ * The SystemClock is built with maxSeconds as its own sync period, so that it
+ * still handles the initial syncs and a sync at least every maxSeconds. Every
+ * sync, whether from the SystemClock or from this policy, is seen through
+ * getLastSyncTime(), and its getClockSkew() is the error accumulated since
+ * the previous sync. If the error is under half of skewBoundSeconds, the
+ * period is doubled, up to maxSeconds. If it reaches skewBoundSeconds, the
+ * period is scaled down to where the error would be half of skewBoundSeconds,
+ * down to minSeconds. Otherwise, the period is kept. A skew of a minute or
+ * more comes from setNow() rather than from drift, and is ignored.
+ *
+ * The skew is in whole seconds, so a skewBoundSeconds of 1 doubles the period
+ * on every sync until it reaches maxSeconds, whatever the drift. It should be
+ * at least 2.
+ *
+ * When the period is due, loop() calls forceSync(), which reads the reference
+ * clock synchronously. If that read fails, the next attempt is backed off
+ * exponentially from minSeconds, up to the current period. The SystemClock has
+ * no public non-blocking sync request, so use this policy only with a
+ * reference clock which reads quickly, like a DS3231. With an NtpClock,
+ * forceSync() would block the whole loop() for up to its request timeout.
+ */
+class SyncPolicy {
+  public:
+    /**
+     * Constructor.
+     *
+     * @param systemClock the SystemClock, with maxSeconds as its sync period
+     * @param minSeconds shortest sync period
+     * @param maxSeconds longest sync period
+     * @param skewBoundSeconds the clock skew to stay under, at least 2
+     */
+    SyncPolicy(ace_time::clock::SystemClock& systemClock, uint16_t minSeconds,
+        uint16_t maxSeconds, uint8_t skewBoundSeconds) :
+        mSystemClock(systemClock),
+        mMinSeconds(minSeconds),
+        mMaxSeconds(maxSeconds),
+        mSkewBoundSeconds(skewBoundSeconds),
+        mSyncSeconds(minSeconds)
+    {}
+
+    /** Follow the syncs of the SystemClock, and sync it when due. */
+    void loop() {
+      if (! mSystemClock.isInit()) return;
+
+      ace_time::acetime_t lastSyncTime = mSystemClock.getLastSyncTime();
+      if (lastSyncTime != mLastSyncTime) handleSync(lastSyncTime);
+
+      uint16_t waitSeconds = (mNumFailures == 0) ? mSyncSeconds : backoff();
+      ace_time::acetime_t now = mSystemClock.getNow();
+      if (now - mAttemptTime < (ace_time::acetime_t) waitSeconds) return;
+
+      mAttemptTime = now;
+      mSystemClock.forceSync();
+      if (mSystemClock.getLastSyncTime() == lastSyncTime) {
+        if (mNumFailures < 255) mNumFailures++;
+      }
+    }
+
+    /** The current sync period, in seconds. */
+    uint16_t getSyncSeconds() const { return mSyncSeconds; }
+
+    /** Number of failed syncs since the last good one. */
+    uint8_t getNumFailures() const { return mNumFailures; }
+
+  private:
+    /** Largest skew attributed to drift. */
+    static int16_t const kMaxDriftSkew = 60;
+
+    /** Adapt the period to the skew of the sync at lastSyncTime. */
+    void handleSync(ace_time::acetime_t lastSyncTime) {
+      int16_t skew = mSystemClock.getClockSkew();
+      if (skew < 0) skew = -skew;
+
+      // The first sync seen by this policy has no previous sync to measure
+      // the drift from.
+      if (mLastSyncTime != 0 && skew < kMaxDriftSkew) {
+        if (2 * skew < mSkewBoundSeconds) {
+          mSyncSeconds = (mSyncSeconds > mMaxSeconds / 2)
+              ? mMaxSeconds : mSyncSeconds * 2;
+        } else if (skew >= mSkewBoundSeconds) {
+          uint32_t seconds = (uint32_t) (lastSyncTime - mLastSyncTime)
+              * mSkewBoundSeconds / (2 * skew);
+          mSyncSeconds = (seconds < mMinSeconds) ? mMinSeconds
+              : (seconds > mMaxSeconds) ? mMaxSeconds : seconds;
+        }
+      }
+
+      mLastSyncTime = lastSyncTime;
+      mAttemptTime = lastSyncTime;
+      mNumFailures = 0;
+    }
+
+    /** Delay after mNumFailures failed syncs: minSeconds * 2^(n-1). */
+    uint16_t backoff() const {
+      uint16_t seconds = mMinSeconds;
+      for (uint8_t i = 1; i < mNumFailures && seconds < mSyncSeconds; ++i) {
+        seconds *= 2;
+      }
+      return (seconds < mSyncSeconds) ? seconds : mSyncSeconds;
+    }
+
+    ace_time::clock::SystemClock& mSystemClock;
+    uint16_t const mMinSeconds;
+    uint16_t const mMaxSeconds;
+    uint8_t const mSkewBoundSeconds;
+
+    uint16_t mSyncSeconds;
+    ace_time::acetime_t mLastSyncTime = 0;
+    ace_time::acetime_t mAttemptTime = 0;
+    uint8_t mNumFailures = 0;
+};
+
+#endif
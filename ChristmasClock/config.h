@@ -15,9 +15,31 @@
 #define ENABLE_SERIAL_DEBUG 0
 #endif
 
+// Set to 1 to benchmark the Controller and Presenter in each Mode at the end
+// of setup(), printing CSV lines to SERIAL_PORT_MONITOR. On EpoxyDuino, run
+// `make benchmark`, which exits after the benchmark.
+#ifndef ENABLE_BENCHMARK
+#define ENABLE_BENCHMARK 0
+#endif
+
 // PersistentStore
 #define ENABLE_EEPROM 1
 
+// Number of StoredInfo slots in the EEPROM, written in rotation so that each
+// save wears a different slot, and a torn save leaves the previous slot intact.
+// At least 2. The flash-emulated EEPROM of the ESP8266, ESP32 and STM32
+// rewrites its whole buffer on each commit, so more slots do not reduce wear.
+// All the slots also live in that one flash sector, which is erased and
+// rewritten by the commit, so a power loss during a commit can lose every
+// slot. The torn save guarantee holds only on the AVR (and EpoxyDuino).
+#ifndef NUM_STORED_INFO_SLOTS
+  #if defined(ARDUINO_ARCH_AVR) || defined(EPOXY_DUINO)
+    #define NUM_STORED_INFO_SLOTS 8
+  #else
+    #define NUM_STORED_INFO_SLOTS 2
+  #endif
+#endif
+
 // Button options: either digital buttons using ButtonConfig, 2 analog buttons
 // using LadderButtonConfig, or 4 analog buttons using LadderButtonConfig:
 //  * AVR: 10-bit analog pin
@@ -54,6 +76,22 @@
   #define SYSTEM_CLOCK SystemClockCoroutine
 #endif
 
+// Range of the sync period of the SystemClock, adapted by the SyncPolicy to
+// the drift measured by the previous syncs, so that the clock skew stays under
+// SYNC_SKEW_BOUND_SECONDS (at least 2, since the skew is in whole seconds).
+// Failed syncs are retried from SYNC_PERIOD_MIN_SECONDS, backing off
+// exponentially. An NTP build does not use the SyncPolicy, whose syncs block,
+// and syncs every SYNC_PERIOD_MIN_SECONDS instead.
+#ifndef SYNC_PERIOD_MIN_SECONDS
+  #define SYNC_PERIOD_MIN_SECONDS 60
+#endif
+#ifndef SYNC_PERIOD_MAX_SECONDS
+  #define SYNC_PERIOD_MAX_SECONDS 3600
+#endif
+#ifndef SYNC_SKEW_BOUND_SECONDS
+  #define SYNC_SKEW_BOUND_SECONDS 2
+#endif
+
 // Type of LED display.
 #define LED_DISPLAY_TYPE_TM1637 0
 #define LED_DISPLAY_TYPE_MAX7219 1
@@ -33,7 +33,16 @@
  *        Print or set the currently active TimeZone.
  *    sync [status]
  *        Sync the SystemClock from its external source, or print its sync
- *        status.
+ *        status, clock skew and current sync period.
+ *    eeprom [flush]
+ *        Print the number of saves, EEPROM commits and bytes written, or
+ *        commit the pending save now.
+ *    wear {count}
+ *        Simulate {count} saves to the EEPROM (EpoxyDuino only), and print
+ *        the largest number of writes to a single EEPROM cell.
+ *    torn
+ *        Simulate a power loss at every byte of a save (EpoxyDuino only), and
+ *        print the number of torn saves which lost the StoredInfo.
  *		wifi (status | config [{ssid} {password}] | connect)
  *        Print the ESP8266 or ESP32 wifi connection info.
  *        Connect to the wifi network.
@@ -55,6 +64,7 @@
 #include "config.h"
 #include "Controller.h"
 #include "PersistentStore.h"
+#include "SyncPolicy.h"
 
 using ace_routine::CoroutineScheduler;
 using namespace ace_time;
@@ -111,7 +121,29 @@ using ace_utils::cli::CommandHandler;
   #error Unknown BACKUP_TIME_SOURCE_TYPE
 #endif
 
-SYSTEM_CLOCK systemClock(refClock, backupClock, 60 /*syncPeriod*/);
+// The SyncPolicy forces each sync with a blocking read of the reference clock,
+// which would stall loop() for up to the request timeout of the NtpClock. So
+// an NTP build keeps the fixed SYNC_PERIOD_MIN_SECONDS of the systemClock,
+// whose coroutine syncs without blocking. Without a reference clock, there is
+// nothing to sync with.
+#if TIME_SOURCE_TYPE == TIME_SOURCE_TYPE_NONE \
+    || TIME_SOURCE_TYPE == TIME_SOURCE_TYPE_NTP
+  #define ENABLE_SYNC_POLICY 0
+  #define SYSTEM_CLOCK_SYNC_SECONDS SYNC_PERIOD_MIN_SECONDS
+#else
+  #define ENABLE_SYNC_POLICY 1
+  #define SYSTEM_CLOCK_SYNC_SECONDS SYNC_PERIOD_MAX_SECONDS
+#endif
+
+SYSTEM_CLOCK systemClock(
+    refClock, backupClock, SYSTEM_CLOCK_SYNC_SECONDS /*syncPeriod*/);
+
+#if ENABLE_SYNC_POLICY
+// Syncs the systemClock as often as its measured drift requires, between
+// SYNC_PERIOD_MIN_SECONDS and the SYNC_PERIOD_MAX_SECONDS of the systemClock.
+SyncPolicy syncPolicy(systemClock, SYNC_PERIOD_MIN_SECONDS,
+    SYNC_PERIOD_MAX_SECONDS, SYNC_SKEW_BOUND_SECONDS);
+#endif
 
 void setupClocks() {
 #if TIME_SOURCE_TYPE == TIME_SOURCE_TYPE_DS3231 \
@@ -137,7 +169,8 @@ void setupClocks() {
 // Create persistent store.
 //-----------------------------------------------------------------------------
 
-const uint32_t kContextId = 0xd86f1c73; // random contextId
+// Random contextId, changed whenever the layout of the StoredInfo changes.
+const uint32_t kContextId = 0x67848f05;
 const uint16_t kStoredInfoEepromAddress = 0;
 
 PersistentStore persistentStore(kContextId, kStoredInfoEepromAddress);
@@ -168,6 +201,219 @@ class ListCommand: public CommandHandler {
     }
 };
 
+/**
+ * Cache command. Prints the hits/misses/evictions of the pinned and scratch
+ * zone processor caches.
+ * Usage:
+ *    cache
+ */
+class CacheCommand: public CommandHandler {
+  public:
+    CacheCommand():
+        CommandHandler(F("cache"), nullptr) {}
+
+    void run(Print& printer, int /*argc*/, const char* const* /*argv*/)
+            const override {
+      controller.printZoneCacheStatsTo(printer);
+    }
+};
+
+#if ENABLE_EEPROM
+
+/**
+ * Eeprom command. Prints the number of saves requested by the Controller, the
+ * number of StoredInfo records committed to the EEPROM and the bytes they
+ * wrote, or commits the pending save immediately.
+ * Usage:
+ *    eeprom - print saves, commits and bytes
+ *    eeprom flush - commit the pending save now
+ */
+class EepromCommand: public CommandHandler {
+  public:
+    EepromCommand():
+        CommandHandler(F("eeprom"), F("[flush]")) {}
+
+    void run(Print& printer, int argc, const char* const* argv)
+            const override {
+      if (argc == 2 && isArgEqual(argv[1], F("flush"))) {
+        uint16_t numWrites = persistentStore.flush();
+        printer.print(F("bytes written: "));
+        printer.println(numWrites);
+      }
+      persistentStore.printStatsTo(printer);
+    }
+};
+
+#endif
+
+#if defined(EPOXY_DUINO) && ENABLE_EEPROM
+
+/**
+ * Wear command. Simulates the wear of the EEPROM by saving the current
+ * StoredInfo {count} times through the PersistentStore, reading it back after
+ * each save. Like an edit on the device, each save changes one byte of the
+ * StoredInfo, cycling through its bytes. A cell is counted as written when its
+ * value changes, like the EEPROM.update() of the AVR. With the wear leveling
+ * of the PersistentStore, the largest count of a single cell should be about
+ * {count} / NUM_STORED_INFO_SLOTS. The average number of bytes written by the
+ * DiffEeprom per save is printed on a second line. The original StoredInfo is
+ * saved again at the end.
+ * Usage:
+ *    wear {count}
+ */
+class WearCommand: public CommandHandler {
+  public:
+    WearCommand():
+        CommandHandler(F("wear"), F("{count}")) {}
+
+    void run(Print& printer, int argc, const char* const* argv)
+            const override {
+      if (argc != 2) {
+        printer.println(F("'wear' requires 'count'"));
+        return;
+      }
+      uint32_t count = atol(argv[1]);
+
+      persistentStore.flush();
+      StoredInfo oldInfo;
+      memset(&oldInfo, 0, sizeof(oldInfo));
+      persistentStore.readStoredInfo(oldInfo);
+      StoredInfo storedInfo;
+      memcpy(&storedInfo, &oldInfo, sizeof(StoredInfo));
+      uint8_t* storedBytes = (uint8_t*) &storedInfo;
+
+      uint16_t size = persistentStore.storedSize();
+      uint8_t* cells = new uint8_t[size];
+      uint32_t* writes = new uint32_t[size]();
+      uint32_t numErrors = 0;
+      uint32_t startBytesWritten = persistentStore.numBytesWritten();
+      for (uint32_t i = 0; i < count; ++i) {
+        for (uint16_t address = 0; address < size; ++address) {
+          cells[address] = EpoxyEepromEspInstance.read(address);
+        }
+
+        storedBytes[i % sizeof(StoredInfo)]++;
+        persistentStore.writeStoredInfo(storedInfo);
+
+        for (uint16_t address = 0; address < size; ++address) {
+          if (EpoxyEepromEspInstance.read(address) != cells[address]) {
+            writes[address]++;
+          }
+        }
+        StoredInfo readInfo;
+        if (! persistentStore.readStoredInfo(readInfo)
+            || memcmp(&readInfo, &storedInfo, sizeof(StoredInfo)) != 0) {
+          numErrors++;
+        }
+      }
+
+      uint32_t numBytesWritten =
+          persistentStore.numBytesWritten() - startBytesWritten;
+      persistentStore.writeStoredInfo(oldInfo);
+
+      uint32_t maxWrites = 0;
+      for (uint16_t address = 0; address < size; ++address) {
+        if (writes[address] > maxWrites) maxWrites = writes[address];
+      }
+      delete[] cells;
+      delete[] writes;
+
+      printer.print(F("saves: "));
+      printer.print(count);
+      printer.print(F("; slots: "));
+      printer.print(PersistentStore::kNumSlots);
+      printer.print(F("; max cell writes: "));
+      printer.print(maxWrites);
+      printer.print(F("; read errors: "));
+      printer.println(numErrors);
+      printer.print(F("bytes per save: "));
+      printer.println((count == 0) ? 0.0 : (float) numBytesWritten / count);
+    }
+};
+
+/**
+ * Torn command. Simulates a power loss at every byte of a save. The current
+ * StoredInfo is saved, followed by a modified copy. Then the bytes changed by
+ * the second save are copied in address order over the EEPROM image of the
+ * first, and the PersistentStore is set up again before each byte, as it
+ * would be after a reboot. Each of these torn images must read back as either
+ * the first or the second StoredInfo. The current StoredInfo is saved again
+ * at the end.
+ * Usage:
+ *    torn
+ */
+class TornCommand: public CommandHandler {
+  public:
+    TornCommand():
+        CommandHandler(F("torn"), nullptr) {}
+
+    void run(Print& printer, int /*argc*/, const char* const* /*argv*/)
+            const override {
+      persistentStore.flush();
+      StoredInfo oldInfo;
+      memset(&oldInfo, 0, sizeof(oldInfo));
+      persistentStore.readStoredInfo(oldInfo);
+      StoredInfo newInfo;
+      memcpy(&newInfo, &oldInfo, sizeof(StoredInfo));
+      uint8_t* newBytes = (uint8_t*) &newInfo;
+      for (uint16_t i = 0; i < sizeof(StoredInfo); ++i) newBytes[i] ^= 0xFF;
+
+      uint16_t size = persistentStore.storedSize();
+      uint8_t* image = new uint8_t[size];
+      uint8_t* newImage = new uint8_t[size];
+      persistentStore.writeStoredInfo(oldInfo);
+      readImage(image, size);
+      persistentStore.writeStoredInfo(newInfo);
+      readImage(newImage, size);
+
+      uint16_t numTorn = 0;
+      uint16_t numLost = 0;
+      for (uint16_t address = 0; address < size; ++address) {
+        if (newImage[address] == image[address]) continue;
+        writeImage(image, size);
+        if (! readsAs(oldInfo) && ! readsAs(newInfo)) numLost++;
+        image[address] = newImage[address];
+        numTorn++;
+      }
+      writeImage(newImage, size);
+      if (! readsAs(newInfo)) numLost++;
+      delete[] image;
+      delete[] newImage;
+
+      persistentStore.writeStoredInfo(oldInfo);
+
+      printer.print(F("torn saves: "));
+      printer.print(numTorn);
+      printer.print(F("; lost: "));
+      printer.println(numLost);
+    }
+
+  private:
+    static void readImage(uint8_t image[], uint16_t size) {
+      for (uint16_t address = 0; address < size; ++address) {
+        image[address] = EpoxyEepromEspInstance.read(address);
+      }
+    }
+
+    /** Write the image to the EEPROM, then rescan it like a reboot. */
+    static void writeImage(const uint8_t image[], uint16_t size) {
+      for (uint16_t address = 0; address < size; ++address) {
+        EpoxyEepromEspInstance.write(address, image[address]);
+      }
+      EpoxyEepromEspInstance.commit();
+      persistentStore.setup();
+    }
+
+    static bool readsAs(const StoredInfo& expected) {
+      StoredInfo storedInfo;
+      memset(&storedInfo, 0, sizeof(storedInfo));
+      return persistentStore.readStoredInfo(storedInfo)
+          && memcmp(&storedInfo, &expected, sizeof(StoredInfo)) == 0;
+    }
+};
+
+#endif
+
 /**
  * Date command.
  * Usage:
@@ -329,6 +575,18 @@ class SyncCommand: public CommandHandler {
         } else {
           printer.println(F("<Never>"));
         }
+        printer.print(F("Clock skew: "));
+        printer.print(mSystemClock.getClockSkew());
+        printer.println(F("s"));
+        printer.print(F("Sync period: "));
+      #if ENABLE_SYNC_POLICY
+        printer.print(syncPolicy.getSyncSeconds());
+        printer.print(F("s; failures: "));
+        printer.println(syncPolicy.getNumFailures());
+      #else
+        printer.print(SYSTEM_CLOCK_SYNC_SECONDS);
+        printer.println(F("s (fixed)"));
+      #endif
         return;
       }
 
@@ -431,18 +689,34 @@ class WifiCommand: public CommandHandler {
 
 // Create a list of CommandHandlers.
 ListCommand listCommand;
+CacheCommand cacheCommand;
 DateCommand dateCommand;
 SyncCommand syncCommand(systemClock);
 TimezoneCommand timezoneCommand;
+#if ENABLE_EEPROM
+EepromCommand eepromCommand;
+#endif
+#if defined(EPOXY_DUINO) && ENABLE_EEPROM
+WearCommand wearCommand;
+TornCommand tornCommand;
+#endif
 #if TIME_SOURCE_TYPE == TIME_SOURCE_TYPE_NTP
 WifiCommand wifiCommand(controller, ntpClock);
 #endif
 
 const CommandHandler* const COMMANDS[] = {
   &listCommand,
+  &cacheCommand,
   &dateCommand,
   &syncCommand,
   &timezoneCommand,
+#if ENABLE_EEPROM
+  &eepromCommand,
+#endif
+#if defined(EPOXY_DUINO) && ENABLE_EEPROM
+  &wearCommand,
+  &tornCommand,
+#endif
 #if TIME_SOURCE_TYPE == TIME_SOURCE_TYPE_NTP
   &wifiCommand,
 #endif
@@ -508,6 +782,135 @@ void setupWiFi() {
 
 #endif
 
+//---------------------------------------------------------------------------
+// Simulate the SyncPolicy against a drifting SystemClock.
+//---------------------------------------------------------------------------
+
+#if ENABLE_SYNC_SIMULATION
+
+static const acetime_t SIMULATION_SECONDS = 86400;
+
+// The reference clock fails to read during this part of the day.
+static const acetime_t SIMULATION_FAIL_START_SECONDS = 40000;
+static const acetime_t SIMULATION_FAIL_END_SECONDS = 50000;
+
+// Interval between calls to loop() of the systemClock and the syncPolicy.
+static const uint16_t SIMULATION_LOOP_MILLIS = 100;
+
+// The true millis of the simulation, kept by the reference clock.
+static uint32_t simulationMillis;
+
+// A reference clock which keeps the true time of the simulation, and fails to
+// read from SIMULATION_FAIL_START_SECONDS to SIMULATION_FAIL_END_SECONDS.
+class SimulatedReferenceClock : public Clock {
+  public:
+    explicit SimulatedReferenceClock(acetime_t startSeconds) :
+        mStartSeconds(startSeconds)
+    {}
+
+    acetime_t getNow() const override {
+      acetime_t elapsedSeconds = simulationMillis / 1000;
+      if (elapsedSeconds >= SIMULATION_FAIL_START_SECONDS
+          && elapsedSeconds < SIMULATION_FAIL_END_SECONDS) {
+        mNumFailedReads++;
+        return LocalDate::kInvalidEpochSeconds;
+      }
+      mNumReads++;
+      return trueNow();
+    }
+
+    void setNow(acetime_t /*epochSeconds*/) override {}
+
+    /** The true time, without counting a read. */
+    acetime_t trueNow() const {
+      return mStartSeconds + (acetime_t) (simulationMillis / 1000);
+    }
+
+    uint32_t numReads() const { return mNumReads; }
+
+    uint32_t numFailedReads() const { return mNumFailedReads; }
+
+  private:
+    acetime_t const mStartSeconds;
+    mutable uint32_t mNumReads = 0;
+    mutable uint32_t mNumFailedReads = 0;
+};
+
+// A SystemClockLoop whose millis() run driftPpm faster than the true millis.
+class SimulatedSystemClock : public SystemClockLoop {
+  public:
+    SimulatedSystemClock(Clock* referenceClock, int32_t driftPpm) :
+        SystemClockLoop(referenceClock, nullptr /*backupClock*/,
+            SYNC_PERIOD_MAX_SECONDS),
+        mDriftPpm(driftPpm)
+    {}
+
+  protected:
+    unsigned long clockMillis() const override {
+      return simulationMillis
+          + (int32_t) ((int64_t) simulationMillis * mDriftPpm / 1000000);
+    }
+
+  private:
+    int32_t const mDriftPpm;
+};
+
+// Run the SyncPolicy for a day against a SystemClock drifting by driftPpm,
+// and print the number of syncs, the failed reads of the reference clock, and
+// the largest difference between the SystemClock and the true time, which is
+// in whole seconds, so it includes up to 1 s of rounding.
+void simulateSync(int32_t driftPpm) {
+  simulationMillis = 0;
+  SimulatedReferenceClock referenceClock(
+      LocalDateTime::forComponents(2025, 1, 1, 0, 0, 0).toEpochSeconds());
+  SimulatedSystemClock simulatedClock(&referenceClock, driftPpm);
+  SyncPolicy policy(simulatedClock, SYNC_PERIOD_MIN_SECONDS,
+      SYNC_PERIOD_MAX_SECONDS, SYNC_SKEW_BOUND_SECONDS);
+  simulatedClock.setup();
+
+  acetime_t maxErrorSeconds = 0;
+  uint32_t endMillis = (uint32_t) SIMULATION_SECONDS * 1000;
+  while (simulationMillis < endMillis) {
+    simulatedClock.loop();
+    policy.loop();
+    if (simulatedClock.isInit()) {
+      acetime_t error = simulatedClock.getNow() - referenceClock.trueNow();
+      if (error < 0) error = -error;
+      if (error > maxErrorSeconds) maxErrorSeconds = error;
+    }
+    simulationMillis += SIMULATION_LOOP_MILLIS;
+  }
+
+  SERIAL_PORT_MONITOR.print(F("driftPpm: "));
+  SERIAL_PORT_MONITOR.print(driftPpm);
+  SERIAL_PORT_MONITOR.print(F("; syncs: "));
+  SERIAL_PORT_MONITOR.print(referenceClock.numReads());
+  SERIAL_PORT_MONITOR.print(F("; failedReads: "));
+  SERIAL_PORT_MONITOR.print(referenceClock.numFailedReads());
+  SERIAL_PORT_MONITOR.print(F("; maxErrorSeconds: "));
+  SERIAL_PORT_MONITOR.println(maxErrorSeconds);
+}
+
+// Simulate the SyncPolicy with the drift of a crystal, and of a ceramic
+// resonator or an internal oscillator.
+void runSyncSimulation() {
+  SERIAL_PORT_MONITOR.print(F("SYNC_PERIOD_MIN_SECONDS: "));
+  SERIAL_PORT_MONITOR.print(SYNC_PERIOD_MIN_SECONDS);
+  SERIAL_PORT_MONITOR.print(F("; SYNC_PERIOD_MAX_SECONDS: "));
+  SERIAL_PORT_MONITOR.print(SYNC_PERIOD_MAX_SECONDS);
+  SERIAL_PORT_MONITOR.print(F("; SYNC_SKEW_BOUND_SECONDS: "));
+  SERIAL_PORT_MONITOR.println(SYNC_SKEW_BOUND_SECONDS);
+  simulateSync(20);
+  simulateSync(100);
+  simulateSync(3000);
+
+#if defined(EPOXY_DUINO)
+  exit(0);
+#endif
+}
+
+#endif
+
 //---------------------------------------------------------------------------
 // Main setup and loop
 //---------------------------------------------------------------------------
@@ -535,6 +938,10 @@ void setup() {
 
   SERIAL_PORT_MONITOR.println(F("setup(): begin"));
 
+#if ENABLE_SYNC_SIMULATION
+  runSyncSimulation();
+#endif
+
   SERIAL_PORT_MONITOR.print(F("sizeof(StoredInfo): "));
   SERIAL_PORT_MONITOR.println(sizeof(StoredInfo));
 
@@ -574,5 +981,10 @@ void loop() {
   systemClock.loop();
 #endif
 
+#if ENABLE_SYNC_POLICY
+  syncPolicy.loop();
+#endif
+
   CoroutineScheduler::loop();
+  persistentStore.loop();
 }
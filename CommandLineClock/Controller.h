@@ -6,6 +6,7 @@
 #include "config.h"
 #include "PersistentStore.h"
 #include "StoredInfo.h"
+#include "ZoneCache.h"
 
 using namespace ace_time;
 using namespace ace_time::clock;
@@ -20,12 +21,23 @@ class Controller {
             kBasicZoneRegistrySize,
             kBasicZoneRegistry,
             mBasicZoneProcessorCache)
+        , mBasicScratchZoneManager(
+            kBasicZoneRegistrySize,
+            kBasicZoneRegistry,
+            mBasicScratchProcessorCache)
+        , mBasicZoneCache(mBasicZoneManager, mBasicScratchZoneManager)
       #endif
       #if ENABLE_TIME_ZONE_TYPE_EXTENDED
         , mExtendedZoneManager(
             kExtendedZoneRegistrySize,
             kExtendedZoneRegistry,
             mExtendedZoneProcessorCache)
+        , mExtendedScratchZoneManager(
+            kExtendedZoneRegistrySize,
+            kExtendedZoneRegistry,
+            mExtendedScratchProcessorCache)
+        , mExtendedZoneCache(
+            mExtendedZoneManager, mExtendedScratchZoneManager)
       #endif
     {}
 
@@ -63,7 +75,10 @@ class Controller {
     void setBasicTimeZoneForIndex(uint16_t zoneIndex = 0) {
       SERIAL_PORT_MONITOR.print(F("setBasicTimeZoneForIndex(): "));
       SERIAL_PORT_MONITOR.println(zoneIndex);
-      mTimeZone = mBasicZoneManager.createForZoneIndex(zoneIndex);
+      TimeZoneData zoneData =
+          mBasicZoneCache.createForZoneIndex(zoneIndex).toTimeZoneData();
+      mBasicZoneCache.pin(&zoneData);
+      mTimeZone = mBasicZoneCache.createForTimeZoneData(zoneData);
       validateAndSaveTimeZone();
     }
   #endif
@@ -73,7 +88,10 @@ class Controller {
     void setExtendedTimeZoneForIndex(uint16_t zoneIndex = 0) {
       SERIAL_PORT_MONITOR.print(F("setExtendedTimeZoneForIndex(): "));
       SERIAL_PORT_MONITOR.println(zoneIndex);
-      mTimeZone = mExtendedZoneManager.createForZoneIndex(zoneIndex);
+      TimeZoneData zoneData =
+          mExtendedZoneCache.createForZoneIndex(zoneIndex).toTimeZoneData();
+      mExtendedZoneCache.pin(&zoneData);
+      mTimeZone = mExtendedZoneCache.createForTimeZoneData(zoneData);
       validateAndSaveTimeZone();
     }
   #endif
@@ -120,12 +138,12 @@ class Controller {
   #if ENABLE_TIME_ZONE_TYPE_BASIC
     /** Print list of supported zones. */
     void printBasicZonesTo(Print& printer) {
-      for (uint16_t i = 0; i < mBasicZoneManager.zoneRegistrySize(); i++) {
+      for (uint16_t i = 0; i < mBasicZoneCache.zoneRegistrySize(); i++) {
         printer.print('[');
         printer.print(i);
         printer.print(']');
         printer.print(' ');
-        TimeZone tz = mBasicZoneManager.createForZoneIndex(i);
+        TimeZone tz = mBasicZoneCache.createForZoneIndex(i);
         tz.printTo(printer);
         printer.println();
       }
@@ -135,18 +153,33 @@ class Controller {
   #if ENABLE_TIME_ZONE_TYPE_EXTENDED
     /** Print list of supported zones. */
     void printExtendedZonesTo(Print& printer) {
-      for (uint16_t i = 0; i < mExtendedZoneManager.zoneRegistrySize(); i++) {
+      for (uint16_t i = 0; i < mExtendedZoneCache.zoneRegistrySize(); i++) {
         printer.print('[');
         printer.print(i);
         printer.print(']');
         printer.print(' ');
-        TimeZone tz = mExtendedZoneManager.createForZoneIndex(i);
+        TimeZone tz = mExtendedZoneCache.createForZoneIndex(i);
         tz.printTo(printer);
         printer.println();
       }
     }
   #endif
 
+    /** Print the hits/misses/evictions of the zone processor caches. */
+    void printZoneCacheStatsTo(Print& printer) const {
+    #if ENABLE_TIME_ZONE_TYPE_BASIC
+      printer.print(F("basic "));
+      mBasicZoneCache.printStatsTo(printer);
+    #endif
+    #if ENABLE_TIME_ZONE_TYPE_EXTENDED
+      printer.print(F("extended "));
+      mExtendedZoneCache.printStatsTo(printer);
+    #endif
+    #if ! ENABLE_TIME_ZONE_TYPE_BASIC && ! ENABLE_TIME_ZONE_TYPE_EXTENDED
+      printer.println(F("No zone processor caches"));
+    #endif
+    }
+
   private:
   #if ENABLE_TIME_ZONE_TYPE_BASIC
     static const basic::Info::ZoneInfo* const kBasicZoneRegistry[]
@@ -161,27 +194,30 @@ class Controller {
 
     void validateAndSaveTimeZone() {
       if (mTimeZone.isError()) {
-        mTimeZone = mBasicZoneManager.createForZoneInfo(
-            &zonedb::kZoneAmerica_Los_Angeles);
+        TimeZoneData zoneData(zonedb::kZoneIdAmerica_Los_Angeles);
+        mBasicZoneCache.pin(&zoneData);
+        mTimeZone = mBasicZoneCache.createForTimeZoneData(zoneData);
       }
       preserveInfo();
     }
 
-    uint16_t preserveInfo() {
+    void preserveInfo() {
       SERIAL_PORT_MONITOR.println(F("preserveInfo()"));
       mIsStoredInfoValid = true;
       mStoredInfo.timeZoneData = mTimeZone.toTimeZoneData();
-      return mPersistentStore.writeStoredInfo(mStoredInfo);
+      mPersistentStore.saveStoredInfo(mStoredInfo);
     }
 
     void restoreInfo(const StoredInfo& storedInfo) {
       SERIAL_PORT_MONITOR.print(F("restoreInfo(): type="));
       SERIAL_PORT_MONITOR.println(storedInfo.timeZoneData.type);
       #if ENABLE_TIME_ZONE_TYPE_BASIC
-        mTimeZone = mBasicZoneManager.createForTimeZoneData(
+        mBasicZoneCache.pin(&storedInfo.timeZoneData);
+        mTimeZone = mBasicZoneCache.createForTimeZoneData(
             storedInfo.timeZoneData);
       #elif ENABLE_TIME_ZONE_TYPE_EXTENDED
-        mTimeZone = mExtendedZoneManager.createForTimeZoneData(
+        mExtendedZoneCache.pin(&storedInfo.timeZoneData);
+        mTimeZone = mExtendedZoneCache.createForTimeZoneData(
             storedInfo.timeZoneData);
       #else
         mTimeZone = mManualZoneManager.createForTimeZoneData(
@@ -195,12 +231,20 @@ class Controller {
     PersistentStore& mPersistentStore;
 
   #if ENABLE_TIME_ZONE_TYPE_BASIC
+    // The current zone is pinned in mBasicZoneProcessorCache, so that
+    // listing the registry cannot evict it.
     BasicZoneProcessorCache<1> mBasicZoneProcessorCache;
+    BasicZoneProcessorCache<1> mBasicScratchProcessorCache;
     BasicZoneManager mBasicZoneManager;
+    BasicZoneManager mBasicScratchZoneManager;
+    ZoneCache<BasicZoneManager, 1, 1> mBasicZoneCache;
   #endif
   #if ENABLE_TIME_ZONE_TYPE_EXTENDED
     ExtendedZoneProcessorCache<1> mExtendedZoneProcessorCache;
+    ExtendedZoneProcessorCache<1> mExtendedScratchProcessorCache;
     ExtendedZoneManager mExtendedZoneManager;
+    ExtendedZoneManager mExtendedScratchZoneManager;
+    ZoneCache<ExtendedZoneManager, 1, 1> mExtendedZoneCache;
   #endif
   #if ! ENABLE_TIME_ZONE_TYPE_BASIC && ! ENABLE_TIME_ZONE_TYPE_EXTENDED
     ManualZoneManager mManualZoneManager;
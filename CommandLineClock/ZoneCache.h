@@ -0,0 +1,161 @@
+#ifndef COMMAND_LINE_CLOCK_ZONE_CACHE_H
+#define COMMAND_LINE_CLOCK_ZONE_CACHE_H
+
+#include <Arduino.h> // Print
+#include <AceTime.h>
+
+using namespace ace_time;
+
+/**
+ * Wraps 2 ZoneManagers over the same zone registry, each with its own
+ * ZoneProcessorCache, and counts the hits, misses and evictions of those
+ * caches.
+ *
+ * The zones given to pin() (e.g. the current zone) are created through the
+ * pinned ZoneManager, whose cache holds PINNED_SIZE processors. All other
+ * zones, e.g. the zones printed by a listing of the registry, are
+ * created through the scratch ZoneManager, whose cache holds SCRATCH_SIZE
+ * processors. Browsing can thrash only the scratch cache, and can never evict
+ * the processor of a pinned zone.
+ *
+ * The ZoneProcessorCache of AceTime cannot be observed, so each cache is
+ * mirrored by a table of the zoneIds in its slots, replaced in the same
+ * round-robin order as the real cache. The counters are those of the mirrors,
+ * not read from the real caches. They match the real caches as long as the
+ * ZoneManagers are used only through this class, and AceTime keeps its
+ * round-robin replacement.
+ *
+ * PINNED_SIZE and SCRATCH_SIZE are fixed at compile time, like the
+ * ZoneProcessorCaches they describe. The caches do not adapt to the observed
+ * misses: the counters are only there to choose those sizes.
+ */
+template <
+    typename T_ZONE_MANAGER, uint8_t PINNED_SIZE, uint8_t SCRATCH_SIZE>
+class ZoneCache {
+  public:
+    /** Counters of a single ZoneProcessorCache. */
+    struct Stats {
+      uint32_t hits;
+      uint32_t misses;
+      uint32_t evictions;
+    };
+
+    ZoneCache(
+        T_ZONE_MANAGER& pinnedManager,
+        T_ZONE_MANAGER& scratchManager
+    ) :
+        mPinnedManager(pinnedManager),
+        mScratchManager(scratchManager)
+    {}
+
+    /**
+     * Pin the first PINNED_SIZE zones of zones[]. Zones which are no longer
+     * pinned are evicted from the pinned cache by the new ones.
+     */
+    void pin(const TimeZoneData zones[]) {
+      for (uint8_t i = 0; i < PINNED_SIZE; ++i) {
+        mPinnedIds[i] = (zones[i].type == TimeZoneData::kTypeZoneId)
+            ? zones[i].zoneId : 0;
+      }
+    }
+
+    /** Create the TimeZone of zoneData, from the pinned cache if pinned. */
+    TimeZone createForTimeZoneData(const TimeZoneData& zoneData) {
+      if (zoneData.type != TimeZoneData::kTypeZoneId
+          || mPinnedManager.indexForZoneId(zoneData.zoneId)
+              == T_ZONE_MANAGER::kInvalidIndex) {
+        // Manual and unknown zones do not use a zone processor.
+        return mPinnedManager.createForTimeZoneData(zoneData);
+      }
+
+      if (isPinned(zoneData.zoneId)) {
+        mPinned.lookup(zoneData.zoneId);
+        return mPinnedManager.createForTimeZoneData(zoneData);
+      } else {
+        mScratch.lookup(zoneData.zoneId);
+        return mScratchManager.createForTimeZoneData(zoneData);
+      }
+    }
+
+    /** Create the TimeZone at zoneIndex of the registry, for browsing. */
+    TimeZone createForZoneIndex(uint16_t zoneIndex) {
+      TimeZone tz = mScratchManager.createForZoneIndex(zoneIndex);
+      if (zoneIndex < mScratchManager.zoneRegistrySize()) {
+        mScratch.lookup(tz.getZoneId());
+      }
+      return tz;
+    }
+
+    uint16_t indexForZoneId(uint32_t zoneId) const {
+      return mPinnedManager.indexForZoneId(zoneId);
+    }
+
+    uint16_t zoneRegistrySize() const {
+      return mPinnedManager.zoneRegistrySize();
+    }
+
+    /** Counters of the cache of the pinned zones. */
+    const Stats& pinnedStats() const { return mPinned.stats; }
+
+    /** Counters of the cache used for browsing. */
+    const Stats& scratchStats() const { return mScratch.stats; }
+
+    /**
+     * Print the counters of both caches, e.g.
+     * "zone procs: pinned 120/4/0; scratch 3/57/56" (hits/misses/evictions).
+     */
+    void printStatsTo(Print& printer) const {
+      printer.print(F("zone procs: pinned "));
+      printStatsTo(printer, mPinned.stats);
+      printer.print(F("; scratch "));
+      printStatsTo(printer, mScratch.stats);
+      printer.println();
+    }
+
+    /** Print the counters as "hits/misses/evictions". */
+    static void printStatsTo(Print& printer, const Stats& stats) {
+      printer.print(stats.hits);
+      printer.print('/');
+      printer.print(stats.misses);
+      printer.print('/');
+      printer.print(stats.evictions);
+    }
+
+  private:
+    /** Mirror of the slots of a round-robin ZoneProcessorCache. */
+    template <uint8_t SIZE>
+    struct Mirror {
+      /** Look up zoneId in the cache, replacing the next slot on a miss. */
+      void lookup(uint32_t zoneId) {
+        for (uint8_t i = 0; i < SIZE; ++i) {
+          if (ids[i] == zoneId) {
+            stats.hits++;
+            return;
+          }
+        }
+        stats.misses++;
+        if (ids[next] != 0) stats.evictions++;
+        ids[next] = zoneId;
+        next = (next + 1 < SIZE) ? next + 1 : 0;
+      }
+
+      uint32_t ids[SIZE] = {};
+      uint8_t next = 0;
+      Stats stats = {};
+    };
+
+    bool isPinned(uint32_t zoneId) const {
+      for (uint8_t i = 0; i < PINNED_SIZE; ++i) {
+        if (mPinnedIds[i] == zoneId) return true;
+      }
+      return false;
+    }
+
+    T_ZONE_MANAGER& mPinnedManager;
+    T_ZONE_MANAGER& mScratchManager;
+    uint32_t mPinnedIds[PINNED_SIZE] = {};
+    Mirror<PINNED_SIZE> mPinned;
+    Mirror<SCRATCH_SIZE> mScratch;
+};
+
+#endif
@@ -23,6 +23,45 @@
 #define SYNC_TYPE_COROUTINE 1
 #define SYNC_TYPE SYNC_TYPE_LOOP
 
+// Range of the sync period of the SystemClock, adapted by the SyncPolicy to
+// the drift measured by the previous syncs, so that the clock skew stays under
+// SYNC_SKEW_BOUND_SECONDS (at least 2, since the skew is in whole seconds).
+// Failed syncs are retried from SYNC_PERIOD_MIN_SECONDS, backing off
+// exponentially. An NTP build does not use the SyncPolicy, whose syncs block,
+// and syncs every SYNC_PERIOD_MIN_SECONDS instead.
+#ifndef SYNC_PERIOD_MIN_SECONDS
+  #define SYNC_PERIOD_MIN_SECONDS 60
+#endif
+#ifndef SYNC_PERIOD_MAX_SECONDS
+  #define SYNC_PERIOD_MAX_SECONDS 3600
+#endif
+#ifndef SYNC_SKEW_BOUND_SECONDS
+  #define SYNC_SKEW_BOUND_SECONDS 2
+#endif
+
+// Set to 1 to simulate a day of the SyncPolicy against a drifting SystemClock
+// and a reference clock which fails for part of the day, print the number of
+// syncs and the largest error for each drift, and exit. Used by
+// `make simulate` on EpoxyDuino.
+#ifndef ENABLE_SYNC_SIMULATION
+  #define ENABLE_SYNC_SIMULATION 0
+#endif
+
+// Number of StoredInfo slots in the EEPROM, written in rotation so that each
+// save wears a different slot, and a torn save leaves the previous slot intact.
+// At least 2. The flash-emulated EEPROM of the ESP8266, ESP32 and STM32
+// rewrites its whole buffer on each commit, so more slots do not reduce wear.
+// All the slots also live in that one flash sector, which is erased and
+// rewritten by the commit, so a power loss during a commit can lose every
+// slot. The torn save guarantee holds only on the AVR (and EpoxyDuino).
+#ifndef NUM_STORED_INFO_SLOTS
+  #if defined(ARDUINO_ARCH_AVR) || defined(EPOXY_DUINO)
+    #define NUM_STORED_INFO_SLOTS 8
+  #else
+    #define NUM_STORED_INFO_SLOTS 2
+  #endif
+#endif
+
 // ENABLE_TIME_ZONE_TYPE_BASIC and ENABLE_TIME_ZONE_TYPE_EXTENDED determine
 // which ZoneProcessor to support. Small boards like the Pro Micro (30kB
 // flash/2.5kB RAM) cannot support both BasicZoneProcessor and
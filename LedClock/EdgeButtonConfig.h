@@ -0,0 +1,184 @@
+#ifndef LED_CLOCK_EDGE_BUTTON_CONFIG_H
+#define LED_CLOCK_EDGE_BUTTON_CONFIG_H
+
+#include <stdint.h>
+#include <Arduino.h> // digitalRead()
+#include <AceButton.h>
+
+// A function called by an interrupt must be placed in the IRAM of the ESP8266
+// and ESP32.
+#if defined(ESP8266) || defined(ESP32)
+  #define EDGE_BUTTON_ISR_ATTR IRAM_ATTR
+#else
+  #define EDGE_BUTTON_ISR_ATTR
+#endif
+
+/**
+ * A ButtonConfig which feeds the AceButtons from the edges captured by the
+ * pin-change interrupts of their pins, instead of polling digitalRead() every
+ * few millis.
+ *
+ * The interrupt handler of each button calls pushEdge(), which timestamps the
+ * new state of the pin into a ring of CAPACITY edges. The ring has a single
+ * producer (the interrupts) and a single consumer (check(), called from
+ * loop()), so it needs no lock: the producer writes only mHead, the consumer
+ * writes only mTail, and both are single bytes, which are read and written
+ * atomically. An edge pushed into a full ring is dropped, and counted.
+ *
+ * Contact bounce can push more edges than the ring holds before check() drains
+ * it, and the dropped edge may be the last one, the settled state of the pin.
+ * So pushEdge() also writes the state into the latest level of its button,
+ * even when the edge is dropped, and check() applies the latest levels after
+ * the ring is drained. Otherwise a button would be left pressed and generate
+ * LongPressed and RepeatPressed events until its next edge.
+ *
+ * check() replays the pending edges through the AceButtons, by overriding
+ * readButton() and getClock() so that each button sees the state and the
+ * millis of the edge, then checks every button once more at the current
+ * millis, to let the debouncing and the click timers expire. isActive() tells
+ * whether check() has anything to do: an edge is pending, a button is held
+ * down, or a click may still be in progress. When the buttons are idle, they
+ * are not checked at all.
+ *
+ * @tparam NUM_BUTTONS number of buttons, each attached with attach()
+ * @tparam CAPACITY number of edges in the ring, a power of 2 up to 128
+ */
+template <uint8_t NUM_BUTTONS, uint8_t CAPACITY>
+class EdgeButtonConfig : public ace_button::ButtonConfig {
+  public:
+    static_assert(CAPACITY > 0 && CAPACITY <= 128
+        && (CAPACITY & (CAPACITY - 1)) == 0,
+        "CAPACITY must be a power of 2, up to 128");
+
+    /** Attach the button at index i. Must be called before setup(). */
+    void attach(uint8_t i, ace_button::AceButton* button) {
+      mButtons[i] = button;
+    }
+
+    /**
+     * Read the initial state of each button. Must be called after the
+     * pinMode() of the buttons, and before their interrupts are attached.
+     */
+    void setup() {
+      for (uint8_t i = 0; i < NUM_BUTTONS; ++i) {
+        mStates[i] = digitalRead(mButtons[i]->getPin());
+        mLevels[i] = mStates[i];
+      }
+    }
+
+    /**
+     * Queue the new state of the button at index i, which changed at
+     * nowMillis. Called by the interrupt handler of the button, or by a
+     * simulation on the host.
+     */
+    EDGE_BUTTON_ISR_ATTR void pushEdge(
+        uint8_t i, uint8_t state, uint16_t nowMillis) {
+      mLevels[i] = state;
+      uint8_t head = mHead;
+      if ((uint8_t) (head - mTail) >= CAPACITY) {
+        mNumDroppedEdges++;
+        return;
+      }
+      volatile Edge& edge = mEdges[head & (CAPACITY - 1)];
+      edge.millis = nowMillis;
+      edge.button = i;
+      edge.state = state;
+      mHead = head + 1;
+    }
+
+    /** Return true if check() needs to be called at nowMillis. */
+    bool isActive(uint16_t nowMillis) {
+      if (mHead != mTail) return true;
+      for (uint8_t i = 0; i < NUM_BUTTONS; ++i) {
+        if (mStates[i] != mButtons[i]->getDefaultReleasedState()) return true;
+        if (mStates[i] != mLevels[i]) return true;
+      }
+      if (! mSettling) return false;
+
+      uint16_t settleMillis = getDebounceDelay() + getClickDelay()
+          + getDoubleClickDelay();
+      if ((uint16_t) (nowMillis - mLastEdgeMillis) < settleMillis) return true;
+      mSettling = false;
+      return false;
+    }
+
+    /**
+     * Replay the pending edges through the buttons, then check every button
+     * at nowMillis.
+     */
+    void check(uint16_t nowMillis) {
+      mNumChecks++;
+      while (mTail != mHead) {
+        uint8_t tail = mTail;
+        volatile Edge& edge = mEdges[tail & (CAPACITY - 1)];
+        uint8_t i = edge.button;
+        mStates[i] = edge.state;
+        mLastEdgeMillis = edge.millis;
+        mTail = tail + 1;
+
+        mClockMillis = mLastEdgeMillis;
+        mButtons[i]->check();
+        mSettling = true;
+      }
+
+      // An edge pushed after the caller read millis() must not make the clock
+      // go backwards.
+      mClockMillis = ((int16_t) (nowMillis - mLastEdgeMillis) < 0)
+          ? mLastEdgeMillis : nowMillis;
+      for (uint8_t i = 0; i < NUM_BUTTONS; ++i) {
+        // The settled state of an edge dropped from the ring.
+        uint8_t level = mLevels[i];
+        if (level != mStates[i]) {
+          mStates[i] = level;
+          mLastEdgeMillis = mClockMillis;
+          mSettling = true;
+        }
+        mButtons[i]->check();
+      }
+    }
+
+    /** Number of calls to check(). */
+    uint32_t numChecks() const { return mNumChecks; }
+
+    void resetNumChecks() { mNumChecks = 0; }
+
+    /** Number of edges dropped because the ring was full. */
+    uint8_t numDroppedEdges() const { return mNumDroppedEdges; }
+
+    /** The millis of the edge being replayed, or of the last check(). */
+    unsigned long getClock() override { return mClockMillis; }
+
+    /** The state of the pin after the edge being replayed. */
+    int readButton(uint8_t pin) override {
+      for (uint8_t i = 0; i < NUM_BUTTONS; ++i) {
+        if (mButtons[i]->getPin() == pin) return mStates[i];
+      }
+      return HIGH;
+    }
+
+  private:
+    /** A change of the state of a button, at the given millis. */
+    struct Edge {
+      uint16_t millis;
+      uint8_t button;
+      uint8_t state;
+    };
+
+    ace_button::AceButton* mButtons[NUM_BUTTONS] = {};
+    uint8_t mStates[NUM_BUTTONS] = {};
+
+    /** The state of the last edge pushed for each button, even if dropped. */
+    volatile uint8_t mLevels[NUM_BUTTONS] = {};
+
+    volatile Edge mEdges[CAPACITY];
+    volatile uint8_t mHead = 0;
+    volatile uint8_t mTail = 0;
+    volatile uint8_t mNumDroppedEdges = 0;
+
+    uint16_t mClockMillis = 0;
+    uint16_t mLastEdgeMillis = 0;
+    bool mSettling = false;
+    uint32_t mNumChecks = 0;
+};
+
+#endif
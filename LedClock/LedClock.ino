@@ -23,6 +23,9 @@ Supported boards are:
 #include <AceTimeClock.h>
 #include "PersistentStore.h"
 #include "Controller.h"
+#include "Benchmark.h"
+#include "EdgeButtonConfig.h"
+#include "SyncPolicy.h"
 
 #if defined(ARDUINO_ARCH_AVR) || defined(EPOXY_DUINO)
 #include <digitalWriteFast.h>
@@ -45,7 +48,8 @@ using namespace ace_wire;
 // Configure PersistentStore
 //------------------------------------------------------------------
 
-const uint32_t kContextId = 0xbe5af950; // random contextId
+// Random contextId, changed whenever the layout of the StoredInfo changes.
+const uint32_t kContextId = 0x6e3467ba;
 const uint16_t kStoredInfoEepromAddress = 0;
 
 PersistentStore persistentStore(kContextId, kStoredInfoEepromAddress);
@@ -170,7 +174,29 @@ static ExtendedZoneManager zoneManager(
   #error Unknown BACKUP_TIME_SOURCE_TYPE
 #endif
 
-SYSTEM_CLOCK systemClock(refClock, backupClock, 60 /*syncPeriod*/);
+// The SyncPolicy forces each sync with a blocking read of the reference clock,
+// which would stall loop() for up to the request timeout of the NtpClock. So
+// an NTP build keeps the fixed SYNC_PERIOD_MIN_SECONDS of the systemClock,
+// whose coroutine syncs without blocking. Without a reference clock, there is
+// nothing to sync with.
+#if TIME_SOURCE_TYPE == TIME_SOURCE_TYPE_NONE \
+    || TIME_SOURCE_TYPE == TIME_SOURCE_TYPE_NTP
+  #define ENABLE_SYNC_POLICY 0
+  #define SYSTEM_CLOCK_SYNC_SECONDS SYNC_PERIOD_MIN_SECONDS
+#else
+  #define ENABLE_SYNC_POLICY 1
+  #define SYSTEM_CLOCK_SYNC_SECONDS SYNC_PERIOD_MAX_SECONDS
+#endif
+
+SYSTEM_CLOCK systemClock(
+    refClock, backupClock, SYSTEM_CLOCK_SYNC_SECONDS /*syncPeriod*/);
+
+#if ENABLE_SYNC_POLICY
+// Syncs the systemClock as often as its measured drift requires, between
+// SYNC_PERIOD_MIN_SECONDS and the SYNC_PERIOD_MAX_SECONDS of the systemClock.
+SyncPolicy syncPolicy(systemClock, SYNC_PERIOD_MIN_SECONDS,
+    SYNC_PERIOD_MAX_SECONDS, SYNC_SKEW_BOUND_SECONDS);
+#endif
 
 void setupClocks() {
 #if TIME_SOURCE_TYPE == TIME_SOURCE_TYPE_DS3231 \
@@ -483,7 +509,34 @@ COROUTINE(blinker) {
 // Configure AceButton.
 //------------------------------------------------------------------
 
-#if BUTTON_TYPE == BUTTON_TYPE_DIGITAL
+#if ENABLE_BUTTON_INTERRUPTS && BUTTON_TYPE != BUTTON_TYPE_DIGITAL
+  #error ENABLE_BUTTON_INTERRUPTS requires BUTTON_TYPE_DIGITAL
+#endif
+
+// Millis between checks of the buttons. With ENABLE_BUTTON_INTERRUPTS, only
+// while a press is in progress.
+static const uint8_t BUTTON_CHECK_MILLIS = 10;
+
+#if BUTTON_TYPE == BUTTON_TYPE_DIGITAL && ENABLE_BUTTON_INTERRUPTS
+
+  static const uint8_t MODE_BUTTON_INDEX = 0;
+  static const uint8_t CHANGE_BUTTON_INDEX = 1;
+
+  EdgeButtonConfig<2, 16> buttonConfig;
+  AceButton modeButton(&buttonConfig, MODE_BUTTON_PIN);
+  AceButton changeButton(&buttonConfig, CHANGE_BUTTON_PIN);
+
+  EDGE_BUTTON_ISR_ATTR void modeButtonInterrupt() {
+    buttonConfig.pushEdge(
+        MODE_BUTTON_INDEX, digitalRead(MODE_BUTTON_PIN), millis());
+  }
+
+  EDGE_BUTTON_ISR_ATTR void changeButtonInterrupt() {
+    buttonConfig.pushEdge(
+        CHANGE_BUTTON_INDEX, digitalRead(CHANGE_BUTTON_PIN), millis());
+  }
+
+#elif BUTTON_TYPE == BUTTON_TYPE_DIGITAL
 
   ButtonConfig buttonConfig;
   AceButton modeButton(&buttonConfig, MODE_BUTTON_PIN);
@@ -551,6 +604,19 @@ void setupAceButton() {
   pinMode(CHANGE_BUTTON_PIN, INPUT_PULLUP);
 #endif
 
+#if ENABLE_BUTTON_INTERRUPTS
+  buttonConfig.attach(MODE_BUTTON_INDEX, &modeButton);
+  buttonConfig.attach(CHANGE_BUTTON_INDEX, &changeButton);
+  buttonConfig.setup();
+  // The EpoxyDuino has no interrupts. Its edges are pushed by the benchmark.
+  #if ! defined(EPOXY_DUINO)
+    attachInterrupt(digitalPinToInterrupt(MODE_BUTTON_PIN),
+        modeButtonInterrupt, CHANGE);
+    attachInterrupt(digitalPinToInterrupt(CHANGE_BUTTON_PIN),
+        changeButtonInterrupt, CHANGE);
+  #endif
+#endif
+
   buttonConfig.setEventHandler(handleButtonEvent);
   buttonConfig.setFeature(ButtonConfig::kFeatureLongPress);
   buttonConfig.setFeature(ButtonConfig::kFeatureSuppressAfterLongPress);
@@ -563,15 +629,21 @@ void setupAceButton() {
 // becomes disconnected after 5-10 seconds. See
 // https://github.com/esp8266/Arduino/issues/1634 and
 // https://github.com/esp8266/Arduino/issues/5083.
+//
+// With ENABLE_BUTTON_INTERRUPTS, wait until an interrupt queues an edge, then
+// check the buttons until the press and its click timers are done.
 COROUTINE(checkButtons) {
   COROUTINE_LOOP() {
-  #if BUTTON_TYPE == BUTTON_TYPE_DIGITAL
+  #if ENABLE_BUTTON_INTERRUPTS
+    COROUTINE_AWAIT(buttonConfig.isActive(millis()));
+    buttonConfig.check(millis());
+  #elif BUTTON_TYPE == BUTTON_TYPE_DIGITAL
     modeButton.check();
     changeButton.check();
   #else
     buttonConfig.checkButtons();
   #endif
-    COROUTINE_DELAY(10);
+    COROUTINE_DELAY(BUTTON_CHECK_MILLIS);
   }
 }
 
@@ -641,6 +713,216 @@ void setupWire() {
 #endif
 }
 
+//-----------------------------------------------------------------------------
+// Benchmark the Controller and the Presenter in each Mode.
+//-----------------------------------------------------------------------------
+
+#if ENABLE_BENCHMARK
+
+static const uint16_t BENCHMARK_ITERATIONS = 100;
+
+// Stop if the Mode button never cycles back to the first Mode.
+static const uint8_t BENCHMARK_MAX_MODES = 64;
+
+// Start of the clock in each Mode.
+static acetime_t benchmarkStartSeconds;
+
+// Time each operation BENCHMARK_ITERATIONS times in the current Mode, with the
+// SystemClock advanced by 1 second before each iteration.
+// The update is the Controller alone, and each render is timed by
+// updateDisplay, after both the update and the blink.
+void benchmarkMode(bool /*isViewMode*/) {
+  BenchmarkTimer updateTimer;
+  BenchmarkTimer blinkTimer;
+  BenchmarkTimer displayTimer;
+
+  for (uint16_t i = 0; i < BENCHMARK_ITERATIONS; ++i) {
+    systemClock.setNow(benchmarkStartSeconds + i);
+    updateTimer.start();
+    controller.updateClockInfo();
+    updateTimer.stop();
+    displayTimer.start();
+    presenter.updateDisplay();
+    displayTimer.stop();
+    blinkTimer.start();
+    controller.updateBlinkState();
+    blinkTimer.stop();
+    displayTimer.start();
+    presenter.updateDisplay();
+    displayTimer.stop();
+  }
+
+  uint8_t mode = (uint8_t) controller.getMode();
+  updateTimer.printTo(
+      SERIAL_PORT_MONITOR, F("LedClock"), mode, F("update"));
+  blinkTimer.printTo(
+      SERIAL_PORT_MONITOR, F("LedClock"), mode, F("updateBlinkState"));
+  displayTimer.printTo(
+      SERIAL_PORT_MONITOR, F("LedClock"), mode, F("updateDisplay"));
+}
+
+#if ENABLE_BUTTON_INTERRUPTS
+
+// A simulated edge of the Change button, at the given millis of the run,
+// preceded by the given number of bounces (pairs of opposite edges) in the same
+// millisecond.
+struct BenchmarkEdge {
+  uint16_t millis;
+  uint8_t state;
+  uint8_t bounces;
+};
+
+// A click of the Change button, with contact bounce on the press and the
+// release, in the middle of 3 seconds of idle time.
+static const BenchmarkEdge BENCHMARK_EDGES[] = {
+  {1000, LOW, 0}, {1002, HIGH, 0}, {1003, LOW, 0},
+  {1150, HIGH, 0}, {1151, LOW, 0}, {1152, HIGH, 0},
+};
+
+// The same click, with a longer bounce, which pushes more edges than the ring
+// of the buttonConfig holds before the next check(). The settled edges are
+// dropped.
+static const BenchmarkEdge BENCHMARK_BOUNCE_EDGES[] = {
+  {1000, LOW, 20}, {1150, HIGH, 20},
+};
+
+static const uint16_t BENCHMARK_BUTTON_MILLIS = 3000;
+
+static uint16_t benchmarkButtonMillis;
+static uint16_t benchmarkPressedMillis;
+static bool benchmarkPressed;
+static uint8_t benchmarkLongPresses;
+
+// Record when the first Pressed event arrives, and count the LongPressed and
+// RepeatPressed events, instead of acting on them.
+void handleBenchmarkButton(AceButton* /*button*/, uint8_t eventType,
+    uint8_t /*buttonState*/) {
+  if (eventType == AceButton::kEventPressed && ! benchmarkPressed) {
+    benchmarkPressed = true;
+    benchmarkPressedMillis = benchmarkButtonMillis;
+  } else if (eventType == AceButton::kEventLongPressed
+      || eventType == AceButton::kEventRepeatPressed) {
+    benchmarkLongPresses++;
+  }
+}
+
+// Replay the given edges 1 millisecond at a time, from startMillis, as the
+// checkButtons coroutine would see them: either polling the pin every
+// BUTTON_CHECK_MILLIS, or woken by the interrupts.
+void replayButtonEdges(const BenchmarkEdge* edges, uint8_t numEdges,
+    bool interrupts, uint16_t startMillis) {
+  buttonConfig.setEventHandler(handleBenchmarkButton);
+  buttonConfig.resetNumChecks();
+  benchmarkPressed = false;
+  benchmarkLongPresses = 0;
+
+  uint8_t next = 0;
+  uint8_t state = HIGH;
+  uint8_t polledState = HIGH;
+  uint16_t resumeMillis = startMillis;
+  for (uint16_t t = 0; t < BENCHMARK_BUTTON_MILLIS; ++t) {
+    uint16_t nowMillis = startMillis + t;
+    benchmarkButtonMillis = nowMillis;
+    for (; next < numEdges && edges[next].millis == t; ++next) {
+      state = edges[next].state;
+      if (interrupts) {
+        for (uint8_t i = 0; i < edges[next].bounces; ++i) {
+          buttonConfig.pushEdge(CHANGE_BUTTON_INDEX, state, nowMillis);
+          buttonConfig.pushEdge(CHANGE_BUTTON_INDEX, ! state, nowMillis);
+        }
+        buttonConfig.pushEdge(CHANGE_BUTTON_INDEX, state, nowMillis);
+      }
+    }
+
+    if (interrupts) {
+      if ((int16_t) (nowMillis - resumeMillis) >= 0
+          && buttonConfig.isActive(nowMillis)) {
+        buttonConfig.check(nowMillis);
+        resumeMillis = nowMillis + BUTTON_CHECK_MILLIS;
+      }
+    } else if (t % BUTTON_CHECK_MILLIS == 0) {
+      // A poll sees only the state of the pin at the time of the poll.
+      if (state != polledState) {
+        polledState = state;
+        buttonConfig.pushEdge(CHANGE_BUTTON_INDEX, state, nowMillis);
+      }
+      buttonConfig.check(nowMillis);
+    }
+  }
+
+  buttonConfig.setEventHandler(handleButtonEvent);
+}
+
+// Replay the BENCHMARK_EDGES. Print the number of checks of the buttons (the
+// wakeups) in the whole run, and the millis from the press to its Pressed
+// event. The display is refreshed by the next updateClock, within 100 ms of
+// the event.
+void benchmarkButtons(bool interrupts, uint16_t startMillis) {
+  replayButtonEdges(BENCHMARK_EDGES,
+      sizeof(BENCHMARK_EDGES) / sizeof(BENCHMARK_EDGES[0]),
+      interrupts, startMillis);
+
+  uint8_t mode = (uint8_t) controller.getMode();
+  BenchmarkTimer::printLineTo(SERIAL_PORT_MONITOR, F("LedClock"), mode,
+      interrupts ? F("edgeButtonChecks") : F("pollButtonChecks"),
+      BENCHMARK_BUTTON_MILLIS, buttonConfig.numChecks());
+  BenchmarkTimer::printLineTo(SERIAL_PORT_MONITOR, F("LedClock"), mode,
+      interrupts ? F("edgePressMillis") : F("pollPressMillis"), 1,
+      benchmarkPressed
+          ? benchmarkPressedMillis - startMillis - BENCHMARK_EDGES[0].millis
+          : 0);
+}
+
+// Replay the BENCHMARK_BOUNCE_EDGES through the interrupts. Print the number
+// of dropped edges, and the number of LongPressed and RepeatPressed events,
+// which must be 0 for a click.
+void benchmarkBounce(uint16_t startMillis) {
+  uint8_t droppedEdges = buttonConfig.numDroppedEdges();
+  replayButtonEdges(BENCHMARK_BOUNCE_EDGES,
+      sizeof(BENCHMARK_BOUNCE_EDGES) / sizeof(BENCHMARK_BOUNCE_EDGES[0]),
+      true /*interrupts*/, startMillis);
+
+  uint8_t mode = (uint8_t) controller.getMode();
+  BenchmarkTimer::printLineTo(SERIAL_PORT_MONITOR, F("LedClock"), mode,
+      F("bounceDroppedEdges"), 1,
+      (uint8_t) (buttonConfig.numDroppedEdges() - droppedEdges));
+  BenchmarkTimer::printLineTo(SERIAL_PORT_MONITOR, F("LedClock"), mode,
+      F("bounceLongPresses"), 1, benchmarkLongPresses);
+}
+
+#endif
+
+// Benchmark each Mode, then restore the clock and the StoredInfo changed by
+// the walk through the Modes.
+void runBenchmark() {
+  benchmarkStartSeconds =
+      LocalDateTime::forComponents(2025, 1, 1, 0, 0, 0).toEpochSeconds();
+  acetime_t savedSeconds = systemClock.getNow();
+  uint32_t savedMillis = millis();
+  BenchmarkTimer::printHeaderTo(SERIAL_PORT_MONITOR);
+
+  benchmarkModes(controller, benchmarkMode, BENCHMARK_MAX_MODES);
+
+#if ENABLE_BUTTON_INTERRUPTS
+  benchmarkButtons(false /*interrupts*/, 10000);
+  benchmarkButtons(true /*interrupts*/, 20000);
+  benchmarkBounce(30000);
+#endif
+
+  // Restore the clock moved by the benchmark, and drop the StoredInfo saved
+  // when leaving each change Mode.
+  persistentStore.discard();
+  if (savedSeconds != LocalDateTime::kInvalidEpochSeconds) {
+    systemClock.setNow(savedSeconds + (millis() - savedMillis) / 1000);
+  }
+
+#if defined(EPOXY_DUINO)
+  exit(0);
+#endif
+}
+
+#endif
+
 //------------------------------------------------------------------
 // Main setup and loop
 //------------------------------------------------------------------
@@ -657,9 +939,11 @@ void setup() {
   TXLED0; // LED off
 #endif
 
-#if ENABLE_SERIAL_DEBUG >= 1
+#if ENABLE_SERIAL_DEBUG >= 1 || ENABLE_BENCHMARK >= 1
   Serial.begin(115200); // ESP8266 default of 74880 not supported on Linux
   while (!Serial); // Wait until Serial is ready - Leonardo/Micro
+#endif
+#if ENABLE_SERIAL_DEBUG >= 1
   Serial.println(F("setup(): begin"));
 #endif
 
@@ -674,6 +958,10 @@ void setup() {
   setupAceSegment();
   controller.setup();
 
+#if ENABLE_BENCHMARK
+  runBenchmark();
+#endif
+
 #if ENABLE_SERIAL_DEBUG >= 1
   Serial.println(F("setup(): end"));
 #endif
@@ -684,10 +972,15 @@ void loop() {
   blinker.runCoroutine();
   updateClock.runCoroutine();
   renderLed.runCoroutine();
+  persistentStore.loop();
 
 #if SYSTEM_CLOCK_TYPE == SYSTEM_CLOCK_TYPE_LOOP
   systemClock.loop();
 #elif SYSTEM_CLOCK_TYPE == SYSTEM_CLOCK_TYPE_COROUTINE
   systemClock.runCoroutine();
 #endif
+
+#if ENABLE_SYNC_POLICY
+  syncPolicy.loop();
+#endif
 }
@@ -46,14 +46,25 @@ class Controller {
       updateDateTime();
     }
 
+    /** Return the current Mode, used by the benchmark. */
+    Mode getMode() const { return mClockInfo.mode; }
+
+    /**
+     * Update the ClockInfo from the clock and pass it to the Presenter,
+     * without rendering the display.
+     */
+    void updateClockInfo() {
+      updateDateTime();
+      updatePresenter();
+    }
+
     /**
      * This should be called every 0.1s to support blinking mode and to avoid
      * noticeable drift against the RTC which has a 1 second resolution.
      */
     void update() {
       if (mClockInfo.mode == Mode::kUnknown) return;
-      updateDateTime();
-      updatePresenter();
+      updateClockInfo();
       mPresenter.updateDisplay();
     }
 
@@ -64,6 +75,16 @@ class Controller {
       updatePresenter();
     }
 
+    /**
+     * Set the blinking state explicitly, for a caller which knows the phase
+     * of the second, e.g. the edges of the square wave of the DS3231.
+     */
+    void setBlinkShowState(bool blinkShowState) {
+      mClockInfo.blinkShowState = blinkShowState;
+      mChangingClockInfo.blinkShowState = blinkShowState;
+      updatePresenter();
+    }
+
     void handleModeButtonPress() {
       if (ENABLE_SERIAL_DEBUG >= 2) {
         SERIAL_PORT_MONITOR.println(F("handleModeButtonPress()"));
@@ -388,7 +409,7 @@ class Controller {
       }
       StoredInfo storedInfo;
       storedInfoFromClockInfo(storedInfo, clockInfo);
-      mPersistentStore.writeStoredInfo(storedInfo);
+      mPersistentStore.saveStoredInfo(storedInfo);
     }
 
     /** Convert ClockInfo to StoredInfo. */
@@ -0,0 +1,160 @@
+#ifndef LED_CLOCK_TINY_INTERPOLATING_CLOCK_H
+#define LED_CLOCK_TINY_INTERPOLATING_CLOCK_H
+
+#include <stdint.h>
+#include <Arduino.h> // millis()
+#include <AceTime.h> // acetime_t, LocalDate
+#include <AceTimeClock.h> // Clock
+
+/**
+ * A Clock which reads the RTC once every syncSeconds, and advances the
+ * epochSeconds with millis() in between, instead of reading the RTC over I2C
+ * on every getNow(). A smaller substitute for the SystemClock of AceTimeClock,
+ * without its coroutine, backup clock, or sync status, to fit the flash of the
+ * ATtiny85.
+ *
+ * The RTC has a resolution of 1 second, so a single read says nothing about
+ * where the RTC is within its second. A sync starts a little before the
+ * interpolated second is expected to roll over, and reads the RTC on each
+ * loop() until its second rolls over, then restarts the interpolation from
+ * that moment. The phase is then as accurate as the interval between calls
+ * to loop(), and a sync normally takes 1 or 2 reads.
+ *
+ * The millis() of a board without a crystal (e.g. the internal oscillator of
+ * the ATtiny85) can be off by 1%, which is 0.6 seconds per minute. So each
+ * sync also measures the millis per second of the RTC since the previous
+ * sync, and averages it into the length of the interpolated second.
+ *
+ * The millis are kept in 16 bits, so syncSeconds is at most 60, and getNow()
+ * must be called at least every 60 seconds.
+ */
+class InterpolatingClock : public ace_time::clock::Clock {
+  public:
+    /**
+     * Constructor.
+     *
+     * @param rtcClock the clock of the RTC, e.g. a DS3231Clock
+     * @param syncSeconds seconds between syncs with the RTC, 2-60
+     */
+    InterpolatingClock(Clock& rtcClock, uint8_t syncSeconds) :
+        mRtcClock(rtcClock),
+        mSyncSeconds(syncSeconds)
+    {}
+
+    /**
+     * Sync with the RTC, waiting for its second to roll over. Blocks for up
+     * to 1 second.
+     */
+    void setup() {
+      ace_time::acetime_t startSeconds = mRtcClock.getNow();
+      uint16_t startMillis = clockMillis();
+      ace_time::acetime_t epochSeconds;
+      do {
+        epochSeconds = mRtcClock.getNow();
+      } while (epochSeconds == startSeconds
+          && (uint16_t) ((uint16_t) clockMillis() - startMillis)
+              < kSecondMillis);
+      restart(epochSeconds, clockMillis());
+    }
+
+    /**
+     * Sync with the RTC when due. Should be called every 100-200 ms, which is
+     * also the accuracy of the phase of the seconds.
+     */
+    void loop() {
+      getNow();
+      uint16_t elapsedMillis = (uint16_t) clockMillis() - mSecondMillis;
+      bool isSyncDue = mSecondsSinceSync >= mSyncSeconds
+          || (mSecondsSinceSync + 1 == mSyncSeconds
+              && elapsedMillis >= kSecondMillis - kSyncLeadMillis);
+      if (! isSyncDue) return;
+
+      ace_time::acetime_t epochSeconds = mRtcClock.getNow();
+      if (mSearchSeconds == ace_time::LocalDate::kInvalidEpochSeconds) {
+        mSearchSeconds = epochSeconds;
+      } else if (epochSeconds != mSearchSeconds) {
+        uint16_t nowMillis = clockMillis();
+        updateSecondMillis(
+            epochSeconds - mSyncEpochSeconds, nowMillis - mSyncMillis);
+        restart(epochSeconds, nowMillis);
+      }
+    }
+
+    ace_time::acetime_t getNow() const override {
+      uint16_t nowMillis = clockMillis();
+      while ((uint16_t) (nowMillis - mSecondMillis) >= mMillisPerSecond) {
+        mSecondMillis += mMillisPerSecond;
+        mEpochSeconds++;
+        if (mSecondsSinceSync < 255) mSecondsSinceSync++;
+      }
+      return mEpochSeconds;
+    }
+
+    /**
+     * Set the RTC. Writing the seconds register of the DS3231 restarts its
+     * second, so the interpolation restarts now.
+     */
+    void setNow(ace_time::acetime_t epochSeconds) override {
+      mRtcClock.setNow(epochSeconds);
+      restart(epochSeconds, clockMillis());
+    }
+
+  protected:
+    /** Return the millis(), overridden by the simulation of `make simulate`. */
+    virtual unsigned long clockMillis() const { return ::millis(); }
+
+  private:
+    static uint16_t const kSecondMillis = 1000;
+
+    /** A sync starts this many millis before the expected rollover. */
+    static uint16_t const kSyncLeadMillis = 250;
+
+    /** A measured second outside of 1000 +/- this is ignored. */
+    static uint16_t const kMaxSkewMillis = 50;
+
+    /**
+     * Average the millis per second measured over the last rtcSeconds into
+     * mMillisPerSecond. A measurement which spans a setNow() or a failed read
+     * of the RTC is far off, and is ignored.
+     */
+    void updateSecondMillis(ace_time::acetime_t rtcSeconds,
+        uint16_t elapsedMillis) {
+      if (rtcSeconds < 1 || rtcSeconds > 65) return;
+      uint16_t measured = elapsedMillis / (uint16_t) rtcSeconds;
+      if (measured < kSecondMillis - kMaxSkewMillis
+          || measured > kSecondMillis + kMaxSkewMillis) {
+        return;
+      }
+      mMillisPerSecond = (mMillisPerSecond + measured) / 2;
+    }
+
+    void restart(ace_time::acetime_t epochSeconds, uint16_t nowMillis) {
+      mEpochSeconds = epochSeconds;
+      mSecondMillis = nowMillis;
+      mSecondsSinceSync = 0;
+      mSyncEpochSeconds = epochSeconds;
+      mSyncMillis = nowMillis;
+      mSearchSeconds = ace_time::LocalDate::kInvalidEpochSeconds;
+    }
+
+    Clock& mRtcClock;
+    uint8_t const mSyncSeconds;
+
+    // Advanced by getNow(), which is const.
+    mutable ace_time::acetime_t mEpochSeconds = 0;
+    mutable uint16_t mSecondMillis = 0;
+    mutable uint8_t mSecondsSinceSync = 0;
+
+    /** Length of the interpolated second, in millis. */
+    uint16_t mMillisPerSecond = kSecondMillis;
+
+    /** The RTC, and the millis(), at the last sync. */
+    ace_time::acetime_t mSyncEpochSeconds = 0;
+    uint16_t mSyncMillis = 0;
+
+    /** The RTC at the first read of a sync, or kInvalidEpochSeconds. */
+    ace_time::acetime_t mSearchSeconds =
+        ace_time::LocalDate::kInvalidEpochSeconds;
+};
+
+#endif
@@ -52,6 +52,17 @@ Memory size (flash/ram) for `au --cli verify attiny_tm1637`:
       * Pro Micro: 9996/428 (no EEPROM)
       * ATtiny85: 6902/268 (EEPROM)
       * ATtiny85: 5958/258 (no EEPROM)
+  * Add ENABLE_INTERPOLATING_CLOCK, on by default on the Pro Micro only
+      * Pro Micro: not yet measured (EEPROM)
+      * ATtiny85: not yet measured (EEPROM, ENABLE_INTERPOLATING_CLOCK=1)
+  * Replace the lastRunMillis of each task with a static TaskTable, and idle
+    sleep until the next task is due
+      * Pro Micro: not yet measured (EEPROM)
+      * ATtiny85: not yet measured (EEPROM)
+      * RAM, by count, not measured: 2 bytes per task in the TaskTable. With
+        the TM1637, the 4 tasks replace the 4 static 2-byte lastRunMillis.
+        With the HC595 or ENABLE_SQW_TIME_BASE, each task of period 0 adds 2
+        unused bytes, which the old untimed function did not have.
 */
 
 #include "config.h"
@@ -66,6 +77,14 @@ Memory size (flash/ram) for `au --cli verify attiny_tm1637`:
 #include <AceUtils.h>
 #include <crc_eeprom/crc_eeprom.h> // from AceUtils
 #include "Controller.h"
+#include "SquareWaveClock.h"
+#include "InterpolatingClock.h"
+#include "TaskTable.h"
+#include "Benchmark.h"
+
+#if ENABLE_IDLE_SLEEP
+#include <avr/sleep.h>
+#endif
 
 #if defined(ARDUINO_ARCH_AVR) || defined(EPOXY_DUINO)
 #include <digitalWriteFast.h>
@@ -86,7 +105,8 @@ using namespace ace_wire;
 // Configure PersistentStore
 //------------------------------------------------------------------
 
-const uint32_t kContextId = 0xd12a3e47; // random contextId
+// Random contextId, changed whenever the layout of the StoredInfo changes.
+const uint32_t kContextId = 0xeefb6aaf;
 const uint16_t kStoredInfoEepromAddress = 0;
 
 PersistentStore persistentStore(kContextId, kStoredInfoEepromAddress);
@@ -116,6 +136,51 @@ void setupPersistentStore() {
 
 DS3231Clock<DS3231WireInterface> dsClock(ds3231WireInterface);
 
+#if ENABLE_SQW_TIME_BASE
+  #if ! defined(SQW_INTERRUPT_PIN)
+    #error ENABLE_SQW_TIME_BASE requires SQW_INTERRUPT_PIN
+  #endif
+  #if SQW_VERIFY_SECONDS < 1 || SQW_VERIFY_SECONDS > 255
+    #error SQW_VERIFY_SECONDS must be 1-255
+  #endif
+
+  SquareWaveClock<DS3231WireInterface> sqwClock(
+      ds3231WireInterface, dsClock, SQW_VERIFY_SECONDS);
+
+  void sqwInterrupt() {
+    sqwClock.handleEdge(digitalRead(SQW_INTERRUPT_PIN));
+  }
+
+  // The INT/SQW pin of the DS3231 is open-drain.
+  void setupSquareWave() {
+    pinMode(SQW_INTERRUPT_PIN, INPUT_PULLUP);
+    sqwClock.setup();
+    attachInterrupt(digitalPinToInterrupt(SQW_INTERRUPT_PIN), sqwInterrupt,
+        CHANGE);
+  }
+#endif
+
+#if ENABLE_SQW_TIME_BASE && ENABLE_INTERPOLATING_CLOCK
+  #error Enable only one of ENABLE_SQW_TIME_BASE and ENABLE_INTERPOLATING_CLOCK
+#endif
+
+#if ENABLE_INTERPOLATING_CLOCK
+  #if RTC_SYNC_SECONDS < 2 || RTC_SYNC_SECONDS > 60
+    #error RTC_SYNC_SECONDS must be 2-60
+  #endif
+
+  InterpolatingClock interpolatingClock(dsClock, RTC_SYNC_SECONDS);
+#endif
+
+// The clock read by the Controller.
+#if ENABLE_SQW_TIME_BASE
+  Clock& controllerClock = sqwClock;
+#elif ENABLE_INTERPOLATING_CLOCK
+  Clock& controllerClock = interpolatingClock;
+#else
+  Clock& controllerClock = dsClock;
+#endif
+
 //------------------------------------------------------------------
 // Configure LED display using AceSegment.
 //------------------------------------------------------------------
@@ -218,27 +283,24 @@ void setupAceSegment() {
   ledModule.begin();
 }
 
-void renderLed() {
+// The HC595 is multiplexed, and renderFieldWhenReady() keeps its own timer,
+// so it runs on every pass of the TaskTable.
 #if LED_DISPLAY_TYPE == LED_DISPLAY_TYPE_HC595
-  ledModule.renderFieldWhenReady();
-
+  static const uint16_t RENDER_LED_MILLIS = 0;
+#elif LED_DISPLAY_TYPE == LED_DISPLAY_TYPE_TM1637
+  static const uint16_t RENDER_LED_MILLIS = 5;
 #else
-  static uint16_t lastRunMillis;
+  static const uint16_t RENDER_LED_MILLIS = 200;
+#endif
 
-  uint16_t nowMillis = millis();
-  uint16_t elapsedMillis = nowMillis - lastRunMillis;
-  #if LED_DISPLAY_TYPE == LED_DISPLAY_TYPE_TM1637
-    if (elapsedMillis >= 5) {
-      lastRunMillis = nowMillis;
-      ledModule.flushIncremental();
-    }
-  #elif LED_DISPLAY_TYPE == LED_DISPLAY_TYPE_MAX7219 \
-      || LED_DISPLAY_TYPE == LED_DISPLAY_TYPE_HT16K33
-    if (elapsedMillis >= 200) {
-      lastRunMillis = nowMillis;
-      ledModule.flush();
-    }
-  #endif
+void renderLed() {
+#if LED_DISPLAY_TYPE == LED_DISPLAY_TYPE_HC595
+  ledModule.renderFieldWhenReady();
+#elif LED_DISPLAY_TYPE == LED_DISPLAY_TYPE_TM1637
+  ledModule.flushIncremental();
+#elif LED_DISPLAY_TYPE == LED_DISPLAY_TYPE_MAX7219 \
+    || LED_DISPLAY_TYPE == LED_DISPLAY_TYPE_HT16K33
+  ledModule.flush();
 #endif
 }
 
@@ -247,39 +309,60 @@ void renderLed() {
 //------------------------------------------------------------------
 
 Presenter presenter(ledModule);
-Controller controller(dsClock, persistentStore, presenter);
+Controller controller(controllerClock, persistentStore, presenter);
 
 //------------------------------------------------------------------
 // Update the Presenter Clock periodically.
 //------------------------------------------------------------------
 
+#if ENABLE_SQW_TIME_BASE
+
+// Update the display on each edge of the square wave of the DS3231: the
+// falling edge is the rollover of the second, and the rising edge half a
+// second later, so the blinking is also in phase with the seconds. The
+// DS3231 is read over I2C only by sqwClock.verify(), just after a rollover.
+// Polls the count of the edges on every pass of the TaskTable. The button
+// events call controller.update() themselves, see handleButtonEvent().
+static const uint16_t UPDATE_CLOCK_MILLIS = 0;
+
+void updateClock() {
+  static uint8_t lastEdges;
+
+  uint8_t edges = sqwClock.getEdges();
+  if (edges == lastEdges) return;
+  lastEdges = edges;
+
+  bool isRollover = digitalRead(SQW_INTERRUPT_PIN) == LOW;
+  if (isRollover) sqwClock.verify();
+  controller.setBlinkShowState(isRollover);
+  controller.update();
+}
+
+#else
+
 // The RTC has a resolution of only 1s, so we need to poll it fast enough to
 // make it appear that the display is tracking it correctly. The benchmarking
 // code says that controller.display() runs as fast as or faster than 1ms for
 // all DISPLAY_TYPEs. So we can set this to 100ms without worrying about too
-// much overhead.
-void updateClock() {
-  static uint16_t lastRunMillis;
+// much overhead. With ENABLE_INTERPOLATING_CLOCK, the poll reads millis(), and
+// the DS3231 is read only during a sync, once every RTC_SYNC_SECONDS.
+static const uint16_t UPDATE_CLOCK_MILLIS = 200;
 
-  uint16_t nowMillis = millis();
-  uint16_t elapsedMillis = nowMillis - lastRunMillis;
-  if (elapsedMillis >= 200) {
-    lastRunMillis = nowMillis;
-    controller.update();
-  }
+void updateClock() {
+#if ENABLE_INTERPOLATING_CLOCK
+  interpolatingClock.loop();
+#endif
+  controller.update();
 }
 
-void blinker() {
-  static uint16_t lastRunMillis;
+static const uint16_t BLINKER_MILLIS = 500;
 
-  uint16_t nowMillis = millis();
-  uint16_t elapsedMillis = nowMillis - lastRunMillis;
-  if (elapsedMillis >= 500) {
-    lastRunMillis = nowMillis;
-    controller.updateBlinkState();
-  }
+void blinker() {
+  controller.updateBlinkState();
 }
 
+#endif
+
 //------------------------------------------------------------------
 // Configure AceButton.
 //------------------------------------------------------------------
@@ -344,6 +427,13 @@ void handleButtonEvent(AceButton* button, uint8_t eventType,
         break;
     }
   }
+
+#if ENABLE_SQW_TIME_BASE
+  // updateClock() refreshes the display only on the edges of the square
+  // wave, so show the new Mode or the changed field without waiting for the
+  // next edge, up to 500 ms away.
+  controller.update();
+#endif
 }
 
 void setupAceButton() {
@@ -369,22 +459,225 @@ void setupAceButton() {
 // disconnected after 5-10 seconds. See
 // https://github.com/esp8266/Arduino/issues/1634 and
 // https://github.com/esp8266/Arduino/issues/5083.
+static const uint16_t CHECK_BUTTONS_MILLIS = 5;
+
 void checkButtons() {
-  static uint16_t lastRunMillis;
+#if BUTTON_TYPE == BUTTON_TYPE_DIGITAL
+  modeButton.check();
+  changeButton.check();
+#else
+  buttonConfig.checkButtons();
+#endif
+}
 
-  uint16_t nowMillis = millis();
-  uint16_t elapsedMillis = nowMillis - lastRunMillis;
-  if (elapsedMillis >= 5) {
-    lastRunMillis = nowMillis;
-  #if BUTTON_TYPE == BUTTON_TYPE_DIGITAL
-    modeButton.check();
-    changeButton.check();
-  #else
-    buttonConfig.checkButtons();
-  #endif
+//------------------------------------------------------------------
+// Schedule the tasks.
+//------------------------------------------------------------------
+
+TaskTable<
+  Task<CHECK_BUTTONS_MILLIS, checkButtons>,
+#if ! ENABLE_SQW_TIME_BASE
+  Task<BLINKER_MILLIS, blinker>,
+#endif
+  Task<UPDATE_CLOCK_MILLIS, updateClock>,
+  Task<RENDER_LED_MILLIS, renderLed>
+> tasks;
+
+#if ENABLE_IDLE_SLEEP
+// Sleep in idle mode until waitMillis after nowMillis. Every interrupt wakes
+// the CPU, at least the timer of millis() every 1.024 ms, so the time is
+// checked again after each one.
+void idleSleep(uint16_t nowMillis, uint16_t waitMillis) {
+  set_sleep_mode(SLEEP_MODE_IDLE);
+  while ((uint16_t) ((uint16_t) millis() - nowMillis) < waitMillis) {
+    sleep_mode();
+  }
+}
+#endif
+
+//-----------------------------------------------------------------------------
+// Benchmark the Controller and the Presenter in each Mode.
+//-----------------------------------------------------------------------------
+
+#if ENABLE_BENCHMARK
+
+static const uint16_t BENCHMARK_ITERATIONS = 100;
+
+// Stop if the Mode button never cycles back to the first Mode.
+static const uint8_t BENCHMARK_MAX_MODES = 64;
+
+// Start of the clock in each Mode.
+static acetime_t benchmarkStartSeconds;
+
+// Time each operation BENCHMARK_ITERATIONS times in the current Mode, with the
+// clock of the Controller advanced by 1 second before each iteration.
+// The update is the Controller alone, and each render is timed by
+// updateDisplay, after both the update and the blink.
+void benchmarkMode(bool /*isViewMode*/) {
+  BenchmarkTimer updateTimer;
+  BenchmarkTimer blinkTimer;
+  BenchmarkTimer displayTimer;
+
+  for (uint16_t i = 0; i < BENCHMARK_ITERATIONS; ++i) {
+    controllerClock.setNow(benchmarkStartSeconds + i);
+    updateTimer.start();
+    controller.updateClockInfo();
+    updateTimer.stop();
+    displayTimer.start();
+    presenter.updateDisplay();
+    displayTimer.stop();
+    blinkTimer.start();
+    controller.updateBlinkState();
+    blinkTimer.stop();
+    displayTimer.start();
+    presenter.updateDisplay();
+    displayTimer.stop();
   }
+
+  uint8_t mode = (uint8_t) controller.getMode();
+  updateTimer.printTo(
+      SERIAL_PORT_MONITOR, F("LedClockTiny"), mode, F("update"));
+  blinkTimer.printTo(
+      SERIAL_PORT_MONITOR, F("LedClockTiny"), mode, F("updateBlinkState"));
+  displayTimer.printTo(
+      SERIAL_PORT_MONITOR, F("LedClockTiny"), mode, F("updateDisplay"));
+}
+
+// Benchmark each Mode, then restore the clock and the StoredInfo changed by
+// the walk through the Modes.
+void runBenchmark() {
+  benchmarkStartSeconds =
+      LocalDateTime::forComponents(2025, 1, 1, 0, 0, 0).toEpochSeconds();
+  acetime_t savedSeconds = controllerClock.getNow();
+  uint32_t savedMillis = millis();
+  BenchmarkTimer::printHeaderTo(SERIAL_PORT_MONITOR);
+
+  benchmarkModes(controller, benchmarkMode, BENCHMARK_MAX_MODES);
+
+  // Restore the clock moved by the benchmark, and drop the StoredInfo saved
+  // when leaving each change Mode.
+  persistentStore.discard();
+  if (savedSeconds != LocalDateTime::kInvalidEpochSeconds) {
+    controllerClock.setNow(savedSeconds + (millis() - savedMillis) / 1000);
+  }
+
+#if defined(EPOXY_DUINO)
+  exit(0);
+#endif
 }
 
+#endif
+
+//-----------------------------------------------------------------------------
+// Simulate the InterpolatingClock against a simulated DS3231.
+//-----------------------------------------------------------------------------
+
+#if ENABLE_CLOCK_SIMULATION
+
+static const uint32_t SIMULATION_MILLIS = (uint32_t) 3600 * 1000;
+
+// The period of updateClock() without ENABLE_SQW_TIME_BASE.
+static const uint16_t SIMULATION_UPDATE_MILLIS = 200;
+
+// The millis() of the simulation.
+static uint32_t simulationMillis;
+
+// A DS3231 whose seconds roll over at phaseMillis of the simulated millis(),
+// which run skewPpm faster than the DS3231. Each read takes 1 ms of the
+// simulated time, about the time of an I2C transaction.
+class SimulatedRtcClock : public Clock {
+  public:
+    SimulatedRtcClock(acetime_t startSeconds, int32_t skewPpm,
+        uint16_t phaseMillis) :
+        mStartSeconds(startSeconds),
+        mSkewPpm(skewPpm),
+        mPhaseMillis(phaseMillis)
+    {}
+
+    acetime_t getNow() const override {
+      mNumReads++;
+      simulationMillis++;
+      return trueNow();
+    }
+
+    void setNow(acetime_t /*epochSeconds*/) override {}
+
+    /** The seconds of the DS3231, without counting a read. */
+    acetime_t trueNow() const {
+      int64_t rtcMillis = (int64_t) simulationMillis * 1000000
+          / (1000000 + mSkewPpm) + mPhaseMillis;
+      return mStartSeconds + (acetime_t) (rtcMillis / 1000);
+    }
+
+    uint32_t numReads() const { return mNumReads; }
+
+    void resetNumReads() { mNumReads = 0; }
+
+  private:
+    acetime_t const mStartSeconds;
+    int32_t const mSkewPpm;
+    uint16_t const mPhaseMillis;
+    mutable uint32_t mNumReads = 0;
+};
+
+// An InterpolatingClock which reads the simulated millis().
+class SimulatedInterpolatingClock : public InterpolatingClock {
+  public:
+    using InterpolatingClock::InterpolatingClock;
+
+  protected:
+    unsigned long clockMillis() const override { return simulationMillis; }
+};
+
+// Run the InterpolatingClock for an hour with the given skew of millis(),
+// calling loop() and getNow() every SIMULATION_UPDATE_MILLIS like
+// updateClock(), and print the reads of the DS3231 after setup(), and the
+// number of updates which showed a different second than the DS3231.
+void simulateClock(int32_t skewPpm) {
+  simulationMillis = 0;
+  SimulatedRtcClock rtcClock(
+      LocalDateTime::forComponents(2025, 1, 1, 0, 0, 0).toEpochSeconds(),
+      skewPpm, 300 /*phaseMillis*/);
+  SimulatedInterpolatingClock clock(rtcClock, RTC_SYNC_SECONDS);
+  clock.setup();
+  rtcClock.resetNumReads();
+
+  uint32_t numUpdates = 0;
+  uint32_t numWrongUpdates = 0;
+  uint32_t endMillis = simulationMillis + SIMULATION_MILLIS;
+  while (simulationMillis < endMillis) {
+    simulationMillis += SIMULATION_UPDATE_MILLIS;
+    clock.loop();
+    numUpdates++;
+    if (clock.getNow() != rtcClock.trueNow()) numWrongUpdates++;
+  }
+
+  SERIAL_PORT_MONITOR.print(F("skewPpm: "));
+  SERIAL_PORT_MONITOR.print(skewPpm);
+  SERIAL_PORT_MONITOR.print(F("; rtcReadsPerHour: "));
+  SERIAL_PORT_MONITOR.print(rtcClock.numReads());
+  SERIAL_PORT_MONITOR.print(F("; wrongSecondUpdates: "));
+  SERIAL_PORT_MONITOR.print(numWrongUpdates);
+  SERIAL_PORT_MONITOR.print('/');
+  SERIAL_PORT_MONITOR.println(numUpdates);
+}
+
+// Simulate the InterpolatingClock with an accurate millis(), and with the
+// millis() of the internal oscillator of the ATtiny85 off by 1% either way.
+void runClockSimulation() {
+  SERIAL_PORT_MONITOR.print(F("RTC_SYNC_SECONDS: "));
+  SERIAL_PORT_MONITOR.println(RTC_SYNC_SECONDS);
+  simulateClock(0);
+  simulateClock(10000);
+  simulateClock(-10000);
+
+#if defined(EPOXY_DUINO)
+  exit(0);
+#endif
+}
+
+#endif
+
 //------------------------------------------------------------------
 // Main setup and loop
 //------------------------------------------------------------------
@@ -401,12 +694,19 @@ void setup() {
   TXLED0; // LED off
 #endif
 
-#if ENABLE_SERIAL_DEBUG >= 1
+#if ENABLE_SERIAL_DEBUG >= 1 || ENABLE_BENCHMARK >= 1 \
+    || ENABLE_CLOCK_SIMULATION >= 1
   Serial.begin(115200); // ESP8266 default of 74880 not supported on Linux
   while (!Serial); // Wait until Serial is ready - Leonardo/Micro
+#endif
+#if ENABLE_SERIAL_DEBUG >= 1
   Serial.println(F("setup(): begin"));
 #endif
 
+#if ENABLE_CLOCK_SIMULATION
+  runClockSimulation();
+#endif
+
 #if (TIME_SOURCE_TYPE == TIME_SOURCE_TYPE_DS3231 \
       && DS3231_INTERFACE_TYPE == LED_INTERFACE_TYPE_TWO_WIRE) \
     || (LED_DISPLAY_TYPE == LED_DISPLAY_TYPE_HT16K33 \
@@ -417,16 +717,31 @@ void setup() {
   setupPersistentStore();
   setupAceButton();
   setupAceSegment();
+#if ENABLE_SQW_TIME_BASE
+  setupSquareWave();
+#elif ENABLE_INTERPOLATING_CLOCK
+  interpolatingClock.setup();
+#endif
   controller.setup();
 
+#if ENABLE_BENCHMARK
+  runBenchmark();
+#endif
+
 #if ENABLE_SERIAL_DEBUG >= 1
   Serial.println(F("setup(): end"));
 #endif
 }
 
+// Read millis() once, run the tasks which are due, then sleep until the next
+// one is due.
 void loop() {
-  checkButtons();
-  blinker();
-  updateClock();
-  renderLed();
+  uint16_t nowMillis = millis();
+  uint16_t waitMillis = tasks.runDue(nowMillis);
+  persistentStore.loop();
+#if ENABLE_IDLE_SLEEP
+  idleSleep(nowMillis, waitMillis);
+#else
+  (void) waitMillis;
+#endif
 }
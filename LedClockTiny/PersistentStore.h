@@ -1,6 +1,7 @@
 #ifndef LED_CLOCK_TINY_PERSISTENT_STORE_H
 #define LED_CLOCK_TINY_PERSISTENT_STORE_H
 
+#include <Arduino.h> // millis(), Print
 #include "config.h"
 #include "StoredInfo.h"
 
@@ -26,59 +27,265 @@
   #error Unsupported platform for EEPROM
 #endif
 
+#if NUM_STORED_INFO_SLOTS < 2
+  #error NUM_STORED_INFO_SLOTS must be at least 2
+#endif
+
+/**
+ * Wraps the EEPROM object of the platform, and physically writes a byte only
+ * if it differs from the byte already stored at that address, counting the
+ * bytes actually written. Each EEPROM write takes about 3.3 ms on an AVR, so
+ * skipping the unchanged bytes shortens a save which overwrites a record
+ * similar to the one being written.
+ */
+template <typename T_EEPROM>
+class DiffEeprom {
+  public:
+    explicit DiffEeprom(T_EEPROM& eeprom) : mEeprom(eeprom) {}
+
+    uint8_t read(size_t address) const { return mEeprom.read(address); }
+
+    void write(size_t address, uint8_t value) {
+      if (mEeprom.read(address) == value) return;
+      mEeprom.write(address, value);
+      mNumWrites++;
+    }
+
+    /** Same as write(), for CrcEepromAvr which calls EEPROM.update(). */
+    void update(size_t address, uint8_t value) { write(address, value); }
+
+    /** Used only by CrcEepromEsp. */
+    bool commit() { return mEeprom.commit(); }
+
+    /** Number of bytes written since the last resetNumWrites(). */
+    uint16_t numWrites() const { return mNumWrites; }
+
+    void resetNumWrites() { mNumWrites = 0; }
+
+  private:
+    T_EEPROM& mEeprom;
+    uint16_t mNumWrites = 0;
+};
+
 /**
  * A abstraction that knows how to store a StoreInfo object into a platform's
  * EEPROM, using the CrcEeprom class to validate its CRC. This class knows how
  * to wrap and configure different collaborating objects on different platforms.
+ *
+ * To spread the wear of the EEPROM, the StoredInfo is written into a ring of
+ * NUM_STORED_INFO_SLOTS slots starting at the given address, each write going
+ * into the slot after the previous one, tagged with an incrementing sequence
+ * number. The newest record is the valid slot with the highest sequence
+ * number. A write interrupted by a power loss fails the CRC of its own slot
+ * only, so setup() falls back to the previous record in the other slot. The
+ * scan in setup() reads every slot, so it takes a constant time.
+ *
+ * That guarantee holds only where each byte is written to the EEPROM in
+ * place, i.e. on the AVR and EpoxyDuino. On the ESP8266, ESP32 and STM32, the
+ * EEPROM is emulated in a single flash sector holding all the slots, and each
+ * commit erases and rewrites the whole sector, so a power loss during the
+ * commit can destroy every slot.
+ *
+ * The CrcEeprom writes through a DiffEeprom, so only the bytes of the slot
+ * which differ from the record already stored there are written. That slot
+ * holds the record from kNumSlots saves ago, or erased or unrelated data on
+ * the first lap of the ring, not the newest record. So a save skips only the
+ * bytes which did not change over the last kNumSlots saves, and the sequence
+ * number and the CRC are always rewritten.
+ *
+ * The Controllers call saveStoredInfo(), which only marks the StoredInfo as
+ * dirty. It is committed by loop() after kCommitDelayMillis without another
+ * save, so that a burst of edits costs a single write, which matters on the
+ * ESP8266 and ESP32 where each EEPROM.commit() rewrites a whole flash sector.
+ * Call flush() before sleeping or resetting.
  */
 class PersistentStore {
   public:
+    /** Number of slots in the ring. */
+    static uint8_t const kNumSlots = NUM_STORED_INFO_SLOTS;
+
+    /** Quiet period after the last saveStoredInfo() before committing. */
+    static uint16_t const kCommitDelayMillis = 5000;
+
     PersistentStore(uint32_t contextId, uint16_t address) :
       mAddress(address),
       #if defined(EPOXY_DUINO)
-        mCrcEeprom(EpoxyEepromEspInstance, contextId)
+        mEeprom(EpoxyEepromEspInstance),
       #elif defined(ARDUINO_ARCH_AVR)
-        mCrcEeprom(EEPROM, contextId)
+        mEeprom(EEPROM),
       #elif defined(ESP32) || defined(ESP8266)
-        mCrcEeprom(EEPROM, contextId)
+        mEeprom(EEPROM),
       #elif defined(ARDUINO_ARCH_STM32)
-        mCrcEeprom(BufferedEEPROM, contextId)
+        mEeprom(BufferedEEPROM),
       #endif
+        mCrcEeprom(mEeprom, contextId)
     {}
 
     void setup() {
     #if defined(EPOXY_DUINO)
-      EpoxyEepromEspInstance.begin(
-          ace_utils::crc_eeprom::toSavedSize(sizeof(StoredInfo)));
+      EpoxyEepromEspInstance.begin(storedSize());
     #elif defined(ARDUINO_ARCH_AVR)
       // no setup required
     #elif defined(ESP32) || defined(ESP8266)
-      EEPROM.begin(
-          ace_utils::crc_eeprom::toSavedSize(sizeof(StoredInfo)));
+      EEPROM.begin(storedSize());
     #elif defined(ARDUINO_ARCH_STM32)
       BufferedEEPROM.begin();
     #endif
+
+      findNewestSlot();
     }
 
+    /** Read the newest StoredInfo. Return false if no slot is valid. */
     bool readStoredInfo(StoredInfo& storedInfo) const {
-      return mCrcEeprom.readWithCrc(mAddress, storedInfo);
+      if (mIsDirty) {
+        storedInfo = mPendingInfo;
+        return true;
+      }
+      if (! mIsValid) return false;
+
+      StoredRecord record;
+      if (! mCrcEeprom.readWithCrc(slotAddress(mSlot), record)) return false;
+      storedInfo = record.storedInfo;
+      return true;
     }
 
+    /**
+     * Write the StoredInfo into the slot after the newest one. Return the
+     * number of bytes which were physically written because they changed, or
+     * 0 on failure. The sequence number always changes, so a successful write
+     * returns at least 1.
+     */
     uint16_t writeStoredInfo(const StoredInfo& storedInfo) {
-      return mCrcEeprom.writeWithCrc(mAddress, storedInfo);
+      uint8_t slot = (mIsValid && mSlot + 1 < kNumSlots) ? mSlot + 1 : 0;
+
+      StoredRecord record;
+      record.sequence = mSequence + 1;
+      record.storedInfo = storedInfo;
+      mEeprom.resetNumWrites();
+      if (! mCrcEeprom.writeWithCrc(slotAddress(slot), record)) return 0;
+
+      mIsValid = true;
+      mSlot = slot;
+      mSequence = record.sequence;
+      mNumCommits++;
+      mNumBytesWritten += mEeprom.numWrites();
+      return mEeprom.numWrites();
+    }
+
+    /**
+     * Mark the StoredInfo as dirty. It is written by loop() when no other
+     * save happens within kCommitDelayMillis, or by flush().
+     */
+    void saveStoredInfo(const StoredInfo& storedInfo) {
+      mPendingInfo = storedInfo;
+      mIsDirty = true;
+      mDirtyMillis = millis();
+      mNumSaves++;
+    }
+
+    /** Drop the dirty StoredInfo without committing it. */
+    void discard() { mIsDirty = false; }
+
+    /** Commit the dirty StoredInfo after the quiet period. */
+    void loop() {
+      if (mIsDirty
+          && (uint16_t) ((uint16_t) millis() - mDirtyMillis)
+              >= kCommitDelayMillis) {
+        flush();
+      }
+    }
+
+    /**
+     * Commit the dirty StoredInfo now. Return the number of bytes written, or
+     * 0 if nothing was dirty.
+     */
+    uint16_t flush() {
+      if (! mIsDirty) return 0;
+      mIsDirty = false;
+      return writeStoredInfo(mPendingInfo);
+    }
+
+    /** Number of calls to saveStoredInfo(). */
+    uint16_t numSaves() const { return mNumSaves; }
+
+    /** Number of StoredInfo records written to the EEPROM. */
+    uint16_t numCommits() const { return mNumCommits; }
+
+    /** Number of EEPROM bytes physically written by all the commits. */
+    uint32_t numBytesWritten() const { return mNumBytesWritten; }
+
+    /** Print the counters, e.g. "eeprom: saves 12; commits 3; bytes 41". */
+    void printStatsTo(Print& printer) const {
+      printer.print(F("eeprom: saves "));
+      printer.print(mNumSaves);
+      printer.print(F("; commits "));
+      printer.print(mNumCommits);
+      printer.print(F("; bytes "));
+      printer.println(mNumBytesWritten);
+    }
+
+    /** Number of EEPROM bytes used by the ring, including its start address. */
+    uint16_t storedSize() const {
+      return slotAddress(kNumSlots);
     }
 
   private:
+    /** A StoredInfo tagged with the sequence number of its write. */
+    struct StoredRecord {
+      uint16_t sequence;
+      StoredInfo storedInfo;
+    };
+
+    uint16_t slotAddress(uint8_t slot) const {
+      return mAddress + slot
+          * ace_utils::crc_eeprom::toSavedSize(sizeof(StoredRecord));
+    }
+
+    /**
+     * Find the valid slot with the highest sequence number. The sequence
+     * numbers of the valid slots differ by less than kNumSlots, so they are
+     * compared modulo 2^16 to survive the wrap around.
+     */
+    void findNewestSlot() {
+      mIsValid = false;
+      mSlot = 0;
+      mSequence = 0;
+
+      StoredRecord record;
+      for (uint8_t slot = 0; slot < kNumSlots; ++slot) {
+        if (! mCrcEeprom.readWithCrc(slotAddress(slot), record)) continue;
+        if (! mIsValid || (int16_t) (record.sequence - mSequence) > 0) {
+          mIsValid = true;
+          mSlot = slot;
+          mSequence = record.sequence;
+        }
+      }
+    }
+
     uint16_t const mAddress;
+    uint16_t mSequence = 0;
+    uint8_t mSlot = 0;
+    bool mIsValid = false;
+
+    StoredInfo mPendingInfo;
+    bool mIsDirty = false;
+    uint16_t mDirtyMillis = 0;
+    uint16_t mNumSaves = 0;
+    uint16_t mNumCommits = 0;
+    uint32_t mNumBytesWritten = 0;
 
   #if defined(EPOXY_DUINO)
-    CrcEepromEsp<EpoxyEepromEsp> mCrcEeprom;
+    DiffEeprom<EpoxyEepromEsp> mEeprom;
+    CrcEepromEsp<DiffEeprom<EpoxyEepromEsp>> mCrcEeprom;
   #elif defined(ARDUINO_ARCH_AVR)
-    CrcEepromAvr<EEPROMClass> mCrcEeprom;
+    DiffEeprom<EEPROMClass> mEeprom;
+    CrcEepromAvr<DiffEeprom<EEPROMClass>> mCrcEeprom;
   #elif defined(ESP32) || defined(ESP8266)
-    CrcEepromEsp<EEPROMClass> mCrcEeprom;
+    DiffEeprom<EEPROMClass> mEeprom;
+    CrcEepromEsp<DiffEeprom<EEPROMClass>> mCrcEeprom;
   #elif defined(ARDUINO_ARCH_STM32)
-    CrcEepromEsp<BufferedEEPROMClass> mCrcEeprom;
+    DiffEeprom<BufferedEEPROMClass> mEeprom;
+    CrcEepromEsp<DiffEeprom<BufferedEEPROMClass>> mCrcEeprom;
   #endif
 };
 
@@ -94,6 +301,18 @@ class PersistentStore {
     bool readStoredInfo(StoredInfo&) const { return false; }
 
     uint16_t writeStoredInfo(const StoredInfo&) { return 0; }
+
+    uint16_t storedSize() const { return 0; }
+
+    void saveStoredInfo(const StoredInfo&) {}
+
+    void discard() {}
+
+    void loop() {}
+
+    uint16_t flush() { return 0; }
+
+    uint32_t numBytesWritten() const { return 0; }
 };
 
 #endif // ENABLE_EEPROM
@@ -0,0 +1,152 @@
+#ifndef LED_CLOCK_TINY_SQUARE_WAVE_CLOCK_H
+#define LED_CLOCK_TINY_SQUARE_WAVE_CLOCK_H
+
+#include <stdint.h>
+#include <AceTime.h> // acetime_t, LocalDate
+#include <AceTimeClock.h> // Clock
+
+/**
+ * A Clock which counts the seconds from the 1 Hz square wave of a DS3231 RTC,
+ * instead of reading the RTC over I2C on every getNow().
+ *
+ * setup() routes the 1 Hz square wave to the INT/SQW pin. The interrupt
+ * handler of that pin calls handleEdge() on each edge. The falling edge is
+ * the rollover of the seconds register of the RTC, and the rising edge comes
+ * half a second later. getNow() is the epochSeconds of the last read of the
+ * RTC, plus the number of falling edges since that read. verify() reads the
+ * RTC again every verifySeconds, to correct a missed edge, so the I2C bus is
+ * used only once every verifySeconds.
+ *
+ * The edge counters are single bytes, so they are read atomically from
+ * outside the interrupt, and verifySeconds can be at most 255.
+ *
+ * @tparam T_WIREI an AceWire interface, e.g. SimpleWireFastInterface
+ */
+template <typename T_WIREI>
+class SquareWaveClock : public ace_time::clock::Clock {
+  public:
+    /** I2C address of the DS3231. */
+    static uint8_t const kAddress = 0x68;
+
+    /**
+     * Constructor.
+     *
+     * @param wireInterface the I2C bus of the DS3231
+     * @param rtcClock the DS3231Clock on the same bus
+     * @param verifySeconds seconds between reads of the RTC, 1-255
+     */
+    SquareWaveClock(T_WIREI& wireInterface, Clock& rtcClock,
+        uint8_t verifySeconds) :
+        mWireInterface(wireInterface),
+        mRtcClock(rtcClock),
+        mVerifySeconds(verifySeconds)
+    {}
+
+    /** Enable the 1 Hz square wave, then read the RTC. */
+    void setup() {
+      // INTCN = 0 selects the square wave, and RS2 = RS1 = 0 selects 1 Hz.
+      uint8_t control = readRegister(kControlRegister);
+      writeRegister(kControlRegister,
+          control & ~(kControlIntcn | kControlRs2 | kControlRs1));
+      sync();
+    }
+
+    /**
+     * Count an edge of the square wave, with the level of the pin after the
+     * edge. Called by the interrupt handler of the INT/SQW pin.
+     */
+    void handleEdge(uint8_t level) {
+      if (level == 0) mSeconds++;
+      mEdges++;
+    }
+
+    /** Number of edges counted, modulo 256. Changes every half second. */
+    uint8_t getEdges() const { return mEdges; }
+
+    /**
+     * Read the RTC if verifySeconds have passed since the last read, or if
+     * the last read failed. Should be called just after a falling edge, when
+     * the seconds register of the RTC has just rolled over.
+     */
+    void verify() {
+      if (! mSynced || (uint8_t) (mSeconds - mSyncSeconds) >= mVerifySeconds) {
+        sync();
+      }
+    }
+
+    /** Number of reads of the RTC which disagreed with the count of edges. */
+    uint16_t getNumCorrections() const { return mNumCorrections; }
+
+    ace_time::acetime_t getNow() const override {
+      if (! mSynced) return ace_time::LocalDate::kInvalidEpochSeconds;
+      return mSyncEpochSeconds + (uint8_t) (mSeconds - mSyncSeconds);
+    }
+
+    /**
+     * Set the RTC. Writing the seconds register restarts the square wave, so
+     * that the next falling edge is 1 second later.
+     */
+    void setNow(ace_time::acetime_t epochSeconds) override {
+      mRtcClock.setNow(epochSeconds);
+      mSyncEpochSeconds = epochSeconds;
+      mSyncSeconds = mSeconds;
+      mSynced = true;
+    }
+
+  private:
+    static uint8_t const kControlRegister = 0x0E;
+
+    static uint8_t const kControlIntcn = 0x04;
+    static uint8_t const kControlRs2 = 0x10;
+    static uint8_t const kControlRs1 = 0x08;
+
+    /** Read the RTC, and restart the count of the edges from it. */
+    void sync() {
+      uint8_t seconds = mSeconds;
+      ace_time::acetime_t epochSeconds = mRtcClock.getNow();
+      if (epochSeconds == ace_time::LocalDate::kInvalidEpochSeconds) {
+        mSynced = false;
+        return;
+      }
+
+      if (mSynced && epochSeconds != mSyncEpochSeconds
+          + (uint8_t) (seconds - mSyncSeconds)) {
+        mNumCorrections++;
+      }
+      mSyncEpochSeconds = epochSeconds;
+      mSyncSeconds = seconds;
+      mSynced = true;
+    }
+
+    uint8_t readRegister(uint8_t reg) {
+      mWireInterface.beginTransmission(kAddress);
+      mWireInterface.write(reg);
+      mWireInterface.endTransmission();
+
+      mWireInterface.requestFrom(kAddress, (uint8_t) 1);
+      uint8_t value = mWireInterface.read();
+      mWireInterface.endRequest();
+      return value;
+    }
+
+    void writeRegister(uint8_t reg, uint8_t value) {
+      mWireInterface.beginTransmission(kAddress);
+      mWireInterface.write(reg);
+      mWireInterface.write(value);
+      mWireInterface.endTransmission();
+    }
+
+    T_WIREI& mWireInterface;
+    Clock& mRtcClock;
+    uint8_t const mVerifySeconds;
+
+    volatile uint8_t mSeconds = 0;
+    volatile uint8_t mEdges = 0;
+
+    ace_time::acetime_t mSyncEpochSeconds = 0;
+    uint8_t mSyncSeconds = 0;
+    bool mSynced = false;
+    uint16_t mNumCorrections = 0;
+};
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef LED_CLOCK_TINY_TASK_TABLE_H
+#define LED_CLOCK_TINY_TASK_TABLE_H
+
+#include <stdint.h>
+
+/**
+ * A task of a TaskTable, which calls FUNC every PERIOD millis. A PERIOD of 0
+ * calls FUNC on every pass of the TaskTable, for a task which polls a flag set
+ * by an interrupt, or which keeps its own timer.
+ */
+template <uint16_t PERIOD, void (*FUNC)()>
+struct Task {
+  static uint16_t const kPeriod = PERIOD;
+
+  static void run() { FUNC(); }
+};
+
+/**
+ * A static scheduler of a fixed list of Tasks, whose periods and functions are
+ * template parameters, so that each task can be inlined into a compare and a
+ * direct call, with only the millis of its last run in RAM. A replacement for
+ * the coroutines of AceRoutine, which are too big for the ATtiny85. Its flash
+ * size against the hand-rolled timers is not yet measured, see the memory
+ * sizes in LedClockTiny.ino.
+ *
+ * The list is unrolled recursively: each TaskTable holds the first task, and
+ * inherits from the TaskTable of the remaining tasks. The empty TaskTable<>
+ * at the end of the chain takes no space, as an empty base class.
+ *
+ * Usage:
+ *
+ * @code
+ * TaskTable<
+ *   Task<5, checkButtons>,
+ *   Task<200, updateClock>
+ * > tasks;
+ *
+ * void loop() {
+ *   uint16_t waitMillis = tasks.runDue(millis());
+ *   ...
+ * }
+ * @endcode
+ */
+template <typename... T_TASKS>
+class TaskTable;
+
+/** The end of the list of Tasks. */
+template <>
+class TaskTable<> {
+  public:
+    uint16_t runDue(uint16_t /*nowMillis*/) { return 0xFFFF; }
+};
+
+template <typename T_TASK, typename... T_REST>
+class TaskTable<T_TASK, T_REST...> : private TaskTable<T_REST...> {
+  public:
+    /**
+     * Run each task whose period has elapsed at nowMillis, in the order of
+     * the list. Return the millis until the next task is due, not counting
+     * the tasks with a period of 0, or 0xFFFF if there are none.
+     */
+    uint16_t runDue(uint16_t nowMillis) {
+      uint16_t waitMillis = 0xFFFF;
+      if (T_TASK::kPeriod == 0) {
+        T_TASK::run();
+      } else {
+        uint16_t elapsedMillis = nowMillis - mLastRunMillis;
+        if (elapsedMillis >= T_TASK::kPeriod) {
+          mLastRunMillis = nowMillis;
+          T_TASK::run();
+          elapsedMillis = 0;
+        }
+        waitMillis = T_TASK::kPeriod - elapsedMillis;
+      }
+
+      uint16_t restWaitMillis = TaskTable<T_REST...>::runDue(nowMillis);
+      return (waitMillis < restWaitMillis) ? waitMillis : restWaitMillis;
+    }
+
+  private:
+    uint16_t mLastRunMillis = 0;
+};
+
+#endif
@@ -12,9 +12,58 @@
 #define ENABLE_SERIAL_DEBUG 0
 #endif
 
+// Set to 1 to benchmark the Controller and Presenter in each Mode at the end
+// of setup(), printing CSV lines to SERIAL_PORT_MONITOR. On EpoxyDuino, run
+// `make benchmark`, which exits after the benchmark.
+#ifndef ENABLE_BENCHMARK
+#define ENABLE_BENCHMARK 0
+#endif
+
+// Set to 1 to simulate an hour of the InterpolatingClock against a simulated
+// DS3231, print its reads of the DS3231 and its errors, and exit. Used by
+// `make simulate` on EpoxyDuino.
+#ifndef ENABLE_CLOCK_SIMULATION
+#define ENABLE_CLOCK_SIMULATION 0
+#endif
+
+// Set to 1 to count the seconds from the 1 Hz square wave of the DS3231 on
+// SQW_INTERRUPT_PIN (see SquareWaveClock.h), and update the display on its
+// edges, instead of reading the DS3231 over I2C every 200 ms. The pin must
+// support attachInterrupt(), so this is not available on the ATtiny85, whose
+// only interrupt pin INT0 is the SCL of the DS3231.
+#ifndef ENABLE_SQW_TIME_BASE
+#define ENABLE_SQW_TIME_BASE 0
+#endif
+
+// Seconds between reads of the DS3231 which verify the count of the square
+// wave, at most 255.
+#ifndef SQW_VERIFY_SECONDS
+#define SQW_VERIFY_SECONDS 60
+#endif
+
+// Seconds between syncs of the InterpolatingClock with the DS3231, 2-60.
+#ifndef RTC_SYNC_SECONDS
+#define RTC_SYNC_SECONDS 60
+#endif
+
 // PersistentStore
 #define ENABLE_EEPROM 0
 
+// Number of StoredInfo slots in the EEPROM, written in rotation so that each
+// save wears a different slot, and a torn save leaves the previous slot intact.
+// At least 2. The flash-emulated EEPROM of the ESP8266, ESP32 and STM32
+// rewrites its whole buffer on each commit, so more slots do not reduce wear.
+// All the slots also live in that one flash sector, which is erased and
+// rewritten by the commit, so a power loss during a commit can lose every
+// slot. The torn save guarantee holds only on the AVR (and EpoxyDuino).
+#ifndef NUM_STORED_INFO_SLOTS
+  #if defined(ARDUINO_ARCH_AVR) || defined(EPOXY_DUINO)
+    #define NUM_STORED_INFO_SLOTS 8
+  #else
+    #define NUM_STORED_INFO_SLOTS 2
+  #endif
+#endif
+
 // Button options: either digital buttons using ButtonConfig, 2 analog buttons
 // using LadderButtonConfig, or 4 analog buttons using LadderButtonConfig:
 //  * AVR: 10-bit analog pin
@@ -212,6 +261,7 @@
   #define SDA_PIN SDA
   #define SCL_PIN SCL
   #define WIRE_BIT_DELAY 4
+  #define SQW_INTERRUPT_PIN 7 // INT6
 
   #define LED_DISPLAY_TYPE LED_DISPLAY_TYPE_TM1637
   #define LED_INTERFACE_TYPE INTERFACE_TYPE_SIMPLE_TMI_FAST
@@ -229,6 +279,7 @@
   #define SDA_PIN SDA
   #define SCL_PIN SCL
   #define WIRE_BIT_DELAY 4
+  #define SQW_INTERRUPT_PIN 7 // INT6
 
   #define LED_DISPLAY_TYPE LED_DISPLAY_TYPE_MAX7219
   #define LED_INTERFACE_TYPE INTERFACE_TYPE_SIMPLE_SPI_FAST
@@ -246,6 +297,7 @@
   #define SDA_PIN SDA
   #define SCL_PIN SCL
   #define WIRE_BIT_DELAY 4
+  #define SQW_INTERRUPT_PIN 7 // INT6
 
   #define LED_DISPLAY_TYPE LED_DISPLAY_TYPE_HT16K33
   #define LED_INTERFACE_TYPE INTERFACE_TYPE_SIMPLE_WIRE_FAST
@@ -264,6 +316,7 @@
   #define SDA_PIN SDA
   #define SCL_PIN SCL
   #define WIRE_BIT_DELAY 4
+  #define SQW_INTERRUPT_PIN 7 // INT6
 
   #define LED_DISPLAY_TYPE LED_DISPLAY_TYPE_HC595
   #define LED_INTERFACE_TYPE INTERFACE_TYPE_SIMPLE_SPI_FAST
@@ -276,6 +329,36 @@
   #error Unknown AUNITER environment
 #endif
 
+// Set to 1 to read the DS3231 only every RTC_SYNC_SECONDS, and advance the
+// time with millis() in between (see InterpolatingClock.h), instead of reading
+// the DS3231 over I2C on every update. Cannot be combined with
+// ENABLE_SQW_TIME_BASE. On by default on the Pro Micro and EpoxyDuino, whose
+// flash has room for it. Off by default on the ATtiny85 until its flash size
+// there is recorded in the header of LedClockTiny.ino, to check that it fits
+// the 8 kB flash. `make simulate` prints its reads of the DS3231 per hour.
+#ifndef ENABLE_INTERPOLATING_CLOCK
+  #if (defined(EPOXY_DUINO) \
+      || defined(AUNITER_MICRO_TM1637) \
+      || defined(AUNITER_MICRO_MAX7219) \
+      || defined(AUNITER_MICRO_HT16K33) \
+      || defined(AUNITER_MICRO_HC595)) \
+      && ! ENABLE_SQW_TIME_BASE
+    #define ENABLE_INTERPOLATING_CLOCK 1
+  #else
+    #define ENABLE_INTERPOLATING_CLOCK 0
+  #endif
+#endif
+
+// Set to 1 to put the AVR in idle sleep until the next task of the TaskTable
+// is due. The HC595 must be multiplexed continuously, so it never sleeps.
+#ifndef ENABLE_IDLE_SLEEP
+  #if defined(ARDUINO_ARCH_AVR) && LED_DISPLAY_TYPE != LED_DISPLAY_TYPE_HC595
+    #define ENABLE_IDLE_SLEEP 1
+  #else
+    #define ENABLE_IDLE_SLEEP 0
+  #endif
+#endif
+
 //------------------------------------------------------------------
 // Button state transition nodes.
 //------------------------------------------------------------------
@@ -6,6 +6,12 @@
 
 /** Information about the clock. */
 struct ClockInfo {
+  /** Number of recent doses shown in Mode::kViewDoses. */
+  static uint8_t const kNumRecentDoses = 6;
+
+  /** Number of med schedules. */
+  static uint8_t const kNumMeds = NUM_MEDS;
+
   /** Display mode. */
   Mode mode = Mode::kUnknown;
 
@@ -15,37 +21,66 @@ struct ClockInfo {
   /** Blinking should be suppressed. e.g. when RepeatPress is active. */
   bool suppressBlink = false;
 
+  /** The display flashes because the alarm woke up the clock. */
+  bool isReminding = false;
+
   /** The desired timezone of the clock. */
   ace_time::TimeZoneData timeZoneData;
 
   /** Current time. */
   ace_time::ZonedDateTime dateTime;
 
-  /** Time when the last pill was taken. */
-  uint32_t medStartTime;
+  /** Time when the last pill of each med was taken. */
+  uint32_t medStartTimes[kNumMeds];
 
-  /**
-   * How often the pill should be taken. In Mode::kViewMed mode, the
-   * ChangingClockInfo.medInterval field is overloaded to hold the TimePeriod
-   * corresponding to "time until next med" information.
-   */
-  ace_time::TimePeriod medInterval;
+  /** How often the pill of each med should be taken. 00:00 if unused. */
+  ace_time::TimePeriod medIntervals[kNumMeds];
+
+  /** The med shown in Mode::kViewMed, and changed in Mode::kChangeMedXxx. */
+  uint8_t medIndex = 0;
+
+  /** Time until the med at medIndex is due, shown in Mode::kViewMed. */
+  ace_time::TimePeriod medRemaining;
 
   /**
    * Contrast level for OLED dislay, [0, 9] -> [25, 255]. Essentially brightness
    * because the background is black.
    */
   uint8_t contrastLevel;
+
+  /** Number of valid entries in recentDoses[]. */
+  uint8_t numRecentDoses = 0;
+
+  /** Times of the most recent doses from the DoseLog, newest first. */
+  ace_time::acetime_t recentDoses[kNumRecentDoses];
+
+  /** Index of the med of each of the recentDoses[]. */
+  uint8_t recentDoseMeds[kNumRecentDoses];
 };
 
 inline bool operator==(const ClockInfo& a, const ClockInfo& b) {
+  for (uint8_t i = 0; i < ClockInfo::kNumMeds; ++i) {
+    if (a.medStartTimes[i] != b.medStartTimes[i]
+        || a.medIntervals[i] != b.medIntervals[i]) {
+      return false;
+    }
+  }
+  if (a.numRecentDoses != b.numRecentDoses) return false;
+  for (uint8_t i = 0; i < a.numRecentDoses; ++i) {
+    if (a.recentDoses[i] != b.recentDoses[i]
+        || a.recentDoseMeds[i] != b.recentDoseMeds[i]) {
+      return false;
+    }
+  }
+
   return a.mode == b.mode
       && a.blinkShowState == b.blinkShowState
       && a.suppressBlink == b.suppressBlink
+      && a.isReminding == b.isReminding
       && a.timeZoneData == b.timeZoneData
       && a.dateTime == b.dateTime
-      && a.medStartTime == b.medStartTime
-      && a.medInterval == b.medInterval
+      && a.medIndex == b.medIndex
+      && a.medRemaining == b.medRemaining
       && a.contrastLevel == b.contrastLevel;
 }
 
@@ -10,6 +10,8 @@
 #include "ClockInfo.h"
 #include "StoredInfo.h"
 #include "PersistentStore.h"
+#include "DoseLog.h"
+#include "MedQueue.h"
 #include "Presenter.h"
 
 using ace_common::incrementMod;
@@ -30,10 +32,15 @@ class Controller {
     // Number of minutes to use for a DST offset.
     static const int16_t kDstOffsetMinutes = 60;
 
+    // Seconds between the reminders after the med is due.
+    static const int32_t kReminderRepeatSeconds =
+        REMINDER_REPEAT_MINUTES * (int32_t) 60;
+
     /** Constructor. */
     Controller(
         SystemClock& clock
         , PersistentStore& persistentStore
+        , DoseLog& doseLog
         , Presenter& presenter
       #if TIME_ZONE_TYPE == TIME_ZONE_TYPE_MANUAL
         , ManualZoneManager& zoneManager
@@ -46,6 +53,7 @@ class Controller {
     ) :
         mClock(clock)
         , mPersistentStore(persistentStore)
+        , mDoseLog(doseLog)
         , mPresenter(presenter)
         , mZoneManager(zoneManager)
         , mInitialTimeZoneData(initialTimeZoneData)
@@ -65,6 +73,9 @@ class Controller {
           SERIAL_PORT_MONITOR.println(F("setup(): valid StoredInfo"));
         }
         restoreClockInfo(mClockInfo, storedInfo);
+        for (uint8_t med = 0; med < ClockInfo::kNumMeds; ++med) {
+          updateMedQueue(med);
+        }
       } else {
         if (ENABLE_SERIAL_DEBUG >= 1) {
           SERIAL_PORT_MONITOR.println(
@@ -72,6 +83,7 @@ class Controller {
         }
         setupClockInfo(nowSeconds);
       }
+      readRecentDoses();
     }
 
     void syncClock() {
@@ -81,17 +93,72 @@ class Controller {
       mClockInfo.dateTime = ZonedDateTime::forEpochSeconds(nowSeconds, tz);
     }
 
-    /** Wake from sleep. */
+    /**
+     * Wake from sleep by a button. The wake frame rendered by
+     * prepareToSleep() is for the time of the alarm, which can be hours away
+     * from the button press. So the frame is corrected with the time of the
+     * reference clock while the display is still off, then the display is
+     * turned on.
+     */
     void wakeup() {
       mIsPreparingToSleep = false;
+      syncClock(); // sync from reference clock
+      update();
+      mPresenter.wakeup();
+    }
+
+    /**
+     * Wake from sleep by the alarm of the RTC, and flash the time remaining
+     * in Mode::kViewMed until the next button press or sleep. Turning on the
+     * display shows the reminder frame rendered by prepareToSleep() right
+     * away, then the frame is corrected with the time of the reference clock,
+     * which redraws only if it changed.
+     */
+    void wakeupForReminder() {
+      mIsPreparingToSleep = false;
+      mClockInfo.mode = Mode::kViewMed;
+      mClockInfo.isReminding = true;
       mPresenter.wakeup();
       syncClock(); // sync from reference clock
+      update();
     }
 
-    /** Prepare to sleep. */
-    void prepareToSleep() {
-      mIsPreparingToSleep = true;
+    /**
+     * Return the time of the first reminder after nowSeconds: when the first
+     * med is due, then every kReminderRepeatSeconds until it is taken. Return
+     * LocalDate::kInvalidEpochSeconds if no med is scheduled.
+     */
+    acetime_t nextReminderSeconds(acetime_t nowSeconds) const {
+      if (mMedQueue.empty()) return LocalDate::kInvalidEpochSeconds;
+
+      acetime_t dueSeconds = mMedQueue.top().dueTime;
+      if (nowSeconds < dueSeconds) return dueSeconds;
+
+      int32_t numReminders =
+          (nowSeconds - dueSeconds) / kReminderRepeatSeconds + 1;
+      return dueSeconds + numReminders * kReminderRepeatSeconds;
+    }
+
+    /**
+     * Prepare to sleep at nowSeconds. The display is turned off, then the
+     * frame shown by the next wake up is rendered into the RAM of the OLED,
+     * which keeps it while the display is off. If the RTC alarm is set at
+     * alarmSeconds, that is the reminder frame of wakeupForReminder() at
+     * alarmSeconds. Otherwise (alarmSeconds is kInvalidEpochSeconds), only a
+     * button can wake up, and the current Mode is rendered at nowSeconds.
+     * The first med due is shown after either wake up.
+     */
+    void prepareToSleep(acetime_t nowSeconds, acetime_t alarmSeconds) {
+      mClockInfo.isReminding = false;
+      if (! mMedQueue.empty()) mClockInfo.medIndex = mMedQueue.top().med;
       mPresenter.prepareToSleep();
+      if (alarmSeconds == LocalDate::kInvalidEpochSeconds) {
+        renderWakeFrame(nowSeconds);
+      } else {
+        renderReminderFrame(alarmSeconds);
+      }
+      mIsPreparingToSleep = true;
+      mPersistentStore.flush();
     }
 
     void handleModeButtonPress()  {
@@ -99,9 +166,19 @@ class Controller {
         SERIAL_PORT_MONITOR.println(F("handleModeButtonPress()"));
       }
 
+      mClockInfo.isReminding = false;
       switch (mClockInfo.mode) {
         // View modes
+        // Show each med in turn, then the next screen.
         case Mode::kViewMed:
+          if (mClockInfo.medIndex + 1 < ClockInfo::kNumMeds) {
+            mClockInfo.medIndex++;
+          } else {
+            mClockInfo.medIndex = 0;
+            mClockInfo.mode = Mode::kViewDoses;
+          }
+          break;
+        case Mode::kViewDoses:
           mClockInfo.mode = Mode::kViewDateTime;
           break;
         case Mode::kViewDateTime:
@@ -294,9 +371,12 @@ class Controller {
     }
 
     void saveMedInterval() {
-      if (mClockInfo.medInterval != mChangingClockInfo.medInterval) {
-        mClockInfo.medInterval = mChangingClockInfo.medInterval;
-        mClockInfo.medInterval.second(0);
+      uint8_t med = mClockInfo.medIndex;
+      TimePeriod& interval = mClockInfo.medIntervals[med];
+      if (interval != mChangingClockInfo.medIntervals[med]) {
+        interval = mChangingClockInfo.medIntervals[med];
+        interval.second(0);
+        updateMedQueue(med);
         preserveClockInfo();
       }
     }
@@ -321,12 +401,13 @@ class Controller {
       switch (mClockInfo.mode) {
         case Mode::kChangeMedHour:
           time_period_mutation::incrementHour(
-              mChangingClockInfo.medInterval, MAX_MED_INTERVAL_HOURS);
+              mChangingClockInfo.medIntervals[mChangingClockInfo.medIndex],
+              MAX_MED_INTERVAL_HOURS);
           break;
 
         case Mode::kChangeMedMinute:
           time_period_mutation::incrementMinute(
-              mChangingClockInfo.medInterval);
+              mChangingClockInfo.medIntervals[mChangingClockInfo.medIndex]);
           break;
 
       #if TIME_ZONE_TYPE == TIME_ZONE_TYPE_MANUAL
@@ -436,16 +517,34 @@ class Controller {
 
     void handleChangeButtonLongPress() {
       switch (mClockInfo.mode) {
-        case Mode::kViewMed:
-          mClockInfo.medStartTime = mClockInfo.dateTime.toEpochSeconds();
+        case Mode::kViewMed: {
+          uint8_t med = mClockInfo.medIndex;
+          mClockInfo.isReminding = false;
+          mClockInfo.medStartTimes[med] = mClockInfo.dateTime.toEpochSeconds();
+          updateMedQueue(med);
           preserveClockInfo();
+          mDoseLog.append(med, mClockInfo.medStartTimes[med]);
+          readRecentDoses();
           break;
+        }
 
         default:
           break;
       }
     }
 
+    /** Return the current Mode, used by the benchmark. */
+    Mode getMode() const { return mClockInfo.mode; }
+
+    /**
+     * Update the ClockInfo from the clock and pass it to the Presenter,
+     * without rendering the display.
+     */
+    void updateClockInfo() {
+      updateDateTime();
+      updatePresenter();
+    }
+
     /**
      * This should be called every 0.1s to support blinking mode and to avoid
      * noticeable drift against the RTC which has a 1 second resolution.
@@ -453,8 +552,7 @@ class Controller {
     void update() {
       if (mClockInfo.mode == Mode::kUnknown) return;
       if (mIsPreparingToSleep) return;
-      updateDateTime();
-      updatePresenter();
+      updateClockInfo();
       mPresenter.updateDisplay();
     }
 
@@ -469,10 +567,59 @@ class Controller {
     void preserveClockInfo() {
       StoredInfo storedInfo;
       storedInfo.timeZoneData = mClockInfo.timeZoneData;
-      storedInfo.medStartTime = mClockInfo.medStartTime;
-      storedInfo.medInterval = mClockInfo.medInterval;
+      for (uint8_t i = 0; i < ClockInfo::kNumMeds; ++i) {
+        storedInfo.meds[i].startTime = mClockInfo.medStartTimes[i];
+        storedInfo.meds[i].intervalMinutes =
+            mClockInfo.medIntervals[i].toSeconds() / 60;
+      }
       storedInfo.contrastLevel = mClockInfo.contrastLevel;
-      mPersistentStore.writeStoredInfo(storedInfo);
+      mPersistentStore.saveStoredInfo(storedInfo);
+    }
+
+    /** Queue the med by its due time, or unqueue it if unused. */
+    void updateMedQueue(uint8_t med) {
+      int32_t intervalSeconds = mClockInfo.medIntervals[med].toSeconds();
+      if (intervalSeconds <= 0) {
+        mMedQueue.remove(med);
+      } else {
+        mMedQueue.update(med,
+            (acetime_t) mClockInfo.medStartTimes[med] + intervalSeconds);
+      }
+    }
+
+    /**
+     * Render the frame of wakeupForReminder() at alarmSeconds: the first med
+     * due, in Mode::kViewMed. The Mode and the reminder flag of the ClockInfo
+     * are then restored, so that a button wake before the alarm redraws the
+     * current Mode.
+     */
+    void renderReminderFrame(acetime_t alarmSeconds) {
+      Mode mode = mClockInfo.mode;
+      mClockInfo.mode = Mode::kViewMed;
+      mClockInfo.isReminding = true;
+      renderWakeFrame(alarmSeconds);
+      mClockInfo.mode = mode;
+      mClockInfo.isReminding = false;
+    }
+
+    /**
+     * Render the current Mode at wakeSeconds, with the blinking fields shown,
+     * while the display is off.
+     */
+    void renderWakeFrame(acetime_t wakeSeconds) {
+      TimeZone tz = mZoneManager.createForTimeZoneData(mClockInfo.timeZoneData);
+      mClockInfo.dateTime = ZonedDateTime::forEpochSeconds(wakeSeconds, tz);
+      mClockInfo.blinkShowState = true;
+      mChangingClockInfo.blinkShowState = true;
+      updatePresenter();
+      mPresenter.updateDisplay();
+    }
+
+    /** Copy the most recent doses from the DoseLog into the ClockInfo. */
+    void readRecentDoses() {
+      mClockInfo.numRecentDoses = mDoseLog.readRecent(
+          mClockInfo.recentDoses, mClockInfo.recentDoseMeds,
+          ClockInfo::kNumRecentDoses);
     }
 
     void updateDateTime() {
@@ -502,6 +649,7 @@ class Controller {
     /** Update the rendering info for the Presenter. */
     void updatePresenter() {
       switch (mClockInfo.mode) {
+        case Mode::kViewDoses:
         case Mode::kViewDateTime:
         case Mode::kViewTimeZone:
         case Mode::kViewSettings:
@@ -528,10 +676,8 @@ class Controller {
           break;
 
         case Mode::kViewMed: {
-          // Overload ChangingClockInfo.medInterval to hold the 'time
-          // remaining' TimePeriod information.
           mChangingClockInfo = mClockInfo;
-          mChangingClockInfo.medInterval = getRemainingTimePeriod();
+          mChangingClockInfo.medRemaining = getRemainingTimePeriod();
           mPresenter.setClockInfo(mChangingClockInfo);
           break;
         }
@@ -550,9 +696,10 @@ class Controller {
         return TimePeriod::forError();
       }
 
+      uint8_t med = mClockInfo.medIndex;
       int32_t now = mClockInfo.dateTime.toEpochSeconds();
-      int32_t remainingSeconds = mClockInfo.medStartTime
-          + mClockInfo.medInterval.toSeconds() - now;
+      int32_t remainingSeconds = mClockInfo.medStartTimes[med]
+          + mClockInfo.medIntervals[med].toSeconds() - now;
       if (remainingSeconds > MAX_MED_INTERVAL_HOURS * (int32_t)3600
           || remainingSeconds < -MAX_MED_INTERVAL_HOURS * (int32_t)3600) {
         return TimePeriod::forError();
@@ -563,25 +710,35 @@ class Controller {
 
     void restoreClockInfo(ClockInfo& clockInfo, const StoredInfo& storedInfo) {
       clockInfo.timeZoneData = storedInfo.timeZoneData;
-      clockInfo.medInterval = storedInfo.medInterval;
-      clockInfo.medStartTime = storedInfo.medStartTime;
+      for (uint8_t i = 0; i < ClockInfo::kNumMeds; ++i) {
+        clockInfo.medStartTimes[i] = storedInfo.meds[i].startTime;
+        clockInfo.medIntervals[i] = TimePeriod(
+            storedInfo.meds[i].intervalMinutes * (int32_t) 60);
+      }
       clockInfo.contrastLevel = storedInfo.contrastLevel;
     }
 
     void setupClockInfo(acetime_t nowSeconds) {
       StoredInfo storedInfo;
       storedInfo.timeZoneData = mInitialTimeZoneData;
-      storedInfo.medInterval = TimePeriod(86400); // one day
-      storedInfo.medStartTime = nowSeconds;
-      mClockInfo.contrastLevel = OLED_INITIAL_CONTRAST;
+      for (uint8_t i = 0; i < ClockInfo::kNumMeds; ++i) {
+        storedInfo.meds[i].startTime = nowSeconds;
+        storedInfo.meds[i].intervalMinutes = 0; // unused
+      }
+      storedInfo.meds[0].intervalMinutes = 24 * 60; // one day
+      storedInfo.contrastLevel = OLED_INITIAL_CONTRAST;
 
-      preserveClockInfo();
       restoreClockInfo(mClockInfo, storedInfo);
+      for (uint8_t med = 0; med < ClockInfo::kNumMeds; ++med) {
+        updateMedQueue(med);
+      }
+      preserveClockInfo();
     }
 
   protected:
     SystemClock& mClock;
     PersistentStore& mPersistentStore;
+    DoseLog& mDoseLog;
     Presenter& mPresenter;
 
   #if TIME_ZONE_TYPE == TIME_ZONE_TYPE_MANUAL
@@ -596,6 +753,7 @@ class Controller {
 
     ClockInfo mClockInfo; // current clock
     ClockInfo mChangingClockInfo; // target clock (in change mode)
+    MedQueue<ClockInfo::kNumMeds> mMedQueue; // enabled meds by due time
 
     uint16_t mZoneRegistryIndex;
     bool mSecondFieldCleared;
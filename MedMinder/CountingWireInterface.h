@@ -0,0 +1,53 @@
+#ifndef MED_MINDER_COUNTING_WIRE_INTERFACE_H
+#define MED_MINDER_COUNTING_WIRE_INTERFACE_H
+
+#include <stdint.h>
+
+/**
+ * An AceWire interface which forwards to another one, and counts the I2C
+ * transactions into numTransactions: each beginTransmission() and each
+ * requestFrom(). The DS3231Clock keeps its own copy of the interface, so the
+ * counter is held by reference, and is shared by all the copies.
+ *
+ * @tparam T_WIREI the real AceWire interface, e.g. TwoWireInterface<TwoWire>
+ */
+template <typename T_WIREI>
+class CountingWireInterface {
+  public:
+    CountingWireInterface(
+        const T_WIREI& wireInterface, uint32_t& numTransactions) :
+        mWireInterface(wireInterface),
+        mNumTransactions(numTransactions)
+    {}
+
+    void begin() const { mWireInterface.begin(); }
+
+    void end() const { mWireInterface.end(); }
+
+    void beginTransmission(uint8_t addr) const {
+      mNumTransactions++;
+      mWireInterface.beginTransmission(addr);
+    }
+
+    uint8_t write(uint8_t data) const { return mWireInterface.write(data); }
+
+    uint8_t endTransmission(bool sendStop = true) const {
+      return mWireInterface.endTransmission(sendStop);
+    }
+
+    uint8_t requestFrom(uint8_t addr, uint8_t quantity, bool sendStop = true)
+        const {
+      mNumTransactions++;
+      return mWireInterface.requestFrom(addr, quantity, sendStop);
+    }
+
+    uint8_t read() const { return mWireInterface.read(); }
+
+    void endRequest() const { mWireInterface.endRequest(); }
+
+  private:
+    const T_WIREI& mWireInterface;
+    uint32_t& mNumTransactions;
+};
+
+#endif
@@ -0,0 +1,276 @@
+#ifndef MED_MINDER_DOSE_LOG_H
+#define MED_MINDER_DOSE_LOG_H
+
+#include <stdint.h>
+#include <AceTime.h> // acetime_t
+#include "config.h"
+#include "PersistentStore.h" // DiffEeprom, EEPROM of the platform
+
+#if NUM_MEDS > 16
+  #error NUM_MEDS must be at most 16 to fit in a DoseLog entry
+#endif
+
+#if ENABLE_EEPROM
+
+#include <AceCRC.h>
+
+/**
+ * An append-only log of the times when the medication was taken, stored in
+ * the EEPROM after the slots of the PersistentStore.
+ *
+ * The log is a ring of kCapacity entries of 3 bytes, followed by 2 headers of
+ * 9 bytes. Each entry packs into 16 bits the index of the med which was taken,
+ * in the top kMedBits bits, and the number of minutes since the previous dose
+ * in the other kDeltaBits bits (kUnknownDelta if there was no previous dose,
+ * or if it was too long ago, about 11 days with 4 meds). The entry ends with a
+ * CRC8 over those 16 bits and the index of the dose, so that an entry left
+ * over from a previous lap of the ring fails its CRC. Each header holds the
+ * number of doses ever logged, the time of the newest dose, and a CRC8.
+ *
+ * An append writes the entry, then the header which is not holding the
+ * current count, so a write interrupted by a power loss leaves the other
+ * header intact and the torn dose is simply not logged. Only the bytes which
+ * change are written, through DiffEeprom. setup() reads only the 2 headers,
+ * and the entries are read only when the recent doses are requested.
+ */
+class DoseLog {
+  public:
+    /** Number of doses kept in the log. */
+    static uint16_t const kCapacity = DOSE_LOG_CAPACITY;
+
+    /** Number of bits of the med index in each entry. */
+    static uint8_t const kMedBits = (NUM_MEDS <= 1) ? 0
+        : (NUM_MEDS <= 2) ? 1
+        : (NUM_MEDS <= 4) ? 2
+        : (NUM_MEDS <= 8) ? 3
+        : 4;
+
+    /** Number of bits of the delta minutes in each entry. */
+    static uint8_t const kDeltaBits = 16 - kMedBits;
+
+    /** Delta of a dose whose previous dose is unknown. */
+    static uint16_t const kUnknownDelta = (uint16_t) ((1UL << kDeltaBits) - 1);
+
+    /** Size of each entry. */
+    static uint8_t const kEntrySize = 3;
+
+    /** Size of each header. */
+    static uint8_t const kHeaderSize = 9;
+
+    /** Constructor. The log starts at the given EEPROM address. */
+    explicit DoseLog(uint16_t address) :
+        mAddress(address),
+      #if defined(EPOXY_DUINO)
+        mEeprom(EpoxyEepromEspInstance)
+      #elif defined(ARDUINO_ARCH_AVR)
+        mEeprom(EEPROM)
+      #elif defined(ESP32) || defined(ESP8266)
+        mEeprom(EEPROM)
+      #elif defined(ARDUINO_ARCH_STM32)
+        mEeprom(BufferedEEPROM)
+      #endif
+    {}
+
+    /**
+     * Find the newest header. Must be called after PersistentStore::setup(),
+     * because the EEPROM of the ESP8266 and ESP32 must be enlarged to include
+     * the log.
+     */
+    void setup() {
+    #if defined(EPOXY_DUINO)
+      EpoxyEepromEspInstance.begin(storedSize());
+    #elif defined(ESP32) || defined(ESP8266)
+      EEPROM.begin(storedSize());
+    #endif
+
+      mCount = 0;
+      mLastTime = 0;
+      for (uint8_t slot = 0; slot < 2; ++slot) {
+        uint32_t count;
+        uint32_t lastTime;
+        if (readHeader(slot, count, lastTime) && count > mCount) {
+          mCount = count;
+          mLastTime = lastTime;
+        }
+      }
+    }
+
+    /** Number of doses ever logged. */
+    uint32_t count() const { return mCount; }
+
+    /** Number of EEPROM bytes physically written since setup(). */
+    uint32_t numBytesWritten() const { return mNumBytesWritten; }
+
+    /** Number of EEPROM bytes used by the log, including its start address. */
+    uint16_t storedSize() const {
+      return headerAddress(2);
+    }
+
+    /** Append a dose of the med at index med, taken at doseTime. */
+    void append(uint8_t med, acetime_t doseTime) {
+      uint16_t delta = kUnknownDelta;
+      if (mCount > 0) {
+        int32_t minutes = doseTime / 60 - (acetime_t) mLastTime / 60;
+        if (minutes >= 0 && minutes < kUnknownDelta) delta = minutes;
+      }
+      uint16_t bits = ((uint32_t) med << kDeltaBits) | delta;
+
+      mEeprom.resetNumWrites();
+      uint16_t address = entryAddress(mCount);
+      uint8_t entry[2] = { (uint8_t) bits, (uint8_t) (bits >> 8) };
+      mEeprom.write(address, entry[0]);
+      mEeprom.write(address + 1, entry[1]);
+      mEeprom.write(address + 2, entryCrc(entry, mCount));
+
+      uint32_t count = mCount + 1;
+      uint8_t header[kHeaderSize - 1];
+      toBytes(header, count);
+      toBytes(header + 4, doseTime);
+      address = headerAddress(count & 0x1);
+      for (uint8_t i = 0; i < kHeaderSize - 1; ++i) {
+        mEeprom.write(address + i, header[i]);
+      }
+      mEeprom.write(address + kHeaderSize - 1, crc8(header, kHeaderSize - 1));
+    #if ! defined(ARDUINO_ARCH_AVR)
+      mEeprom.commit();
+    #endif
+
+      mCount = count;
+      mLastTime = doseTime;
+      mNumBytesWritten += mEeprom.numWrites();
+    }
+
+    /**
+     * Copy the times of the newest doses into doseTimes[], and the index of
+     * their med into doseMeds[], newest first, up to num doses. The times are
+     * rounded down to the minute except for the newest. Stop at a dose whose
+     * entry fails its CRC, or whose time is unknown because the delta of the
+     * newer dose is unknown. Return the number of doses copied.
+     */
+    uint8_t readRecent(acetime_t doseTimes[], uint8_t doseMeds[], uint8_t num)
+        const {
+      if (mCount == 0 || num == 0) return 0;
+
+      uint32_t minutes = mLastTime / 60;
+      uint8_t n = 0;
+      for (uint32_t index = mCount - 1; n < num; --index) {
+        if (mCount - index > kCapacity) break;
+        uint8_t med;
+        uint16_t delta;
+        if (! readEntry(index, med, delta)) break;
+        doseTimes[n] = (n == 0) ? (acetime_t) mLastTime : minutes * 60;
+        doseMeds[n] = med;
+        n++;
+        if (delta == kUnknownDelta || index == 0) break;
+        minutes -= delta;
+      }
+      return n;
+    }
+
+  private:
+    /** Version of the layout of the entries. */
+    static uint8_t const kEntryFormat = 2;
+
+    uint16_t entryAddress(uint32_t index) const {
+      return mAddress + (index % kCapacity) * kEntrySize;
+    }
+
+    uint16_t headerAddress(uint8_t slot) const {
+      return mAddress + kCapacity * kEntrySize + slot * kHeaderSize;
+    }
+
+    /**
+     * The entry of the dose at index holds its med, and the delta to the dose
+     * before.
+     */
+    bool readEntry(uint32_t index, uint8_t& med, uint16_t& delta) const {
+      uint16_t address = entryAddress(index);
+      uint8_t entry[2] = { mEeprom.read(address), mEeprom.read(address + 1) };
+      if (mEeprom.read(address + 2) != entryCrc(entry, index)) return false;
+      uint16_t bits = entry[0] | ((uint16_t) entry[1] << 8);
+      med = (uint32_t) bits >> kDeltaBits;
+      delta = bits & kUnknownDelta;
+      return true;
+    }
+
+    bool readHeader(uint8_t slot, uint32_t& count, uint32_t& lastTime) const {
+      uint16_t address = headerAddress(slot);
+      uint8_t header[kHeaderSize];
+      for (uint8_t i = 0; i < kHeaderSize; ++i) {
+        header[i] = mEeprom.read(address + i);
+      }
+      if (header[kHeaderSize - 1] != crc8(header, kHeaderSize - 1)) {
+        return false;
+      }
+      count = fromBytes(header);
+      lastTime = fromBytes(header + 4);
+      return count > 0;
+    }
+
+    /**
+     * The CRC of an entry also covers kEntryFormat, so that the entries of an
+     * older format, without the med index, fail their CRC.
+     */
+    static uint8_t entryCrc(const uint8_t entry[2], uint32_t index) {
+      uint8_t data[7] = { entry[0], entry[1] };
+      toBytes(data + 2, index);
+      data[6] = kEntryFormat;
+      return crc8(data, sizeof(data));
+    }
+
+    static uint8_t crc8(const uint8_t data[], uint8_t size) {
+      return ace_crc::crc8_nibble::crc_calculate(data, size);
+    }
+
+    static void toBytes(uint8_t bytes[4], uint32_t value) {
+      for (uint8_t i = 0; i < 4; ++i) {
+        bytes[i] = value;
+        value >>= 8;
+      }
+    }
+
+    static uint32_t fromBytes(const uint8_t bytes[4]) {
+      uint32_t value = 0;
+      for (uint8_t i = 4; i > 0; --i) {
+        value = (value << 8) | bytes[i - 1];
+      }
+      return value;
+    }
+
+    uint16_t const mAddress;
+    uint32_t mCount = 0;
+    uint32_t mLastTime = 0;
+    uint32_t mNumBytesWritten = 0;
+
+  #if defined(EPOXY_DUINO)
+    DiffEeprom<EpoxyEepromEsp> mEeprom;
+  #elif defined(ARDUINO_ARCH_AVR)
+    DiffEeprom<EEPROMClass> mEeprom;
+  #elif defined(ESP32) || defined(ESP8266)
+    DiffEeprom<EEPROMClass> mEeprom;
+  #elif defined(ARDUINO_ARCH_STM32)
+    DiffEeprom<BufferedEEPROMClass> mEeprom;
+  #endif
+};
+
+#else
+
+/** A DoseLog which remembers nothing, for boards w/o EEPROM. */
+class DoseLog {
+  public:
+    explicit DoseLog(uint16_t) {}
+
+    void setup() {}
+
+    uint32_t count() const { return 0; }
+
+    uint32_t numBytesWritten() const { return 0; }
+
+    void append(uint8_t, acetime_t) {}
+
+    uint8_t readRecent(acetime_t[], uint8_t[], uint8_t) const { return 0; }
+};
+
+#endif // ENABLE_EEPROM
+
+#endif
@@ -0,0 +1,99 @@
+#ifndef MED_MINDER_DS3231_ALARM_H
+#define MED_MINDER_DS3231_ALARM_H
+
+#include <stdint.h>
+#include <AceCommon.h> // decToBcd()
+#include <AceTime.h> // LocalDateTime, acetime_t
+
+/**
+ * Programs the Alarm 1 of a DS3231 RTC, which pulls its INT/SQW pin low when
+ * the date, hour, minute and second of the RTC match the alarm, so that the
+ * alarm can wake the processor from LowPower.powerDown(). The pin stays low
+ * until clearAlarm() is called.
+ *
+ * The DS3231Clock of AceTimeClock keeps the RTC in UTC, so the alarm is
+ * given as epochSeconds, and is converted to UTC date-time components. The
+ * DS3231Clock does not touch the alarm, control or status registers, so both
+ * can share the same I2C bus.
+ *
+ * @tparam T_WIREI an AceWire interface, e.g. TwoWireInterface<TwoWire>
+ */
+template <typename T_WIREI>
+class Ds3231Alarm {
+  public:
+    /** I2C address of the DS3231. */
+    static uint8_t const kAddress = 0x68;
+
+    explicit Ds3231Alarm(T_WIREI& wireInterface) :
+        mWireInterface(wireInterface)
+    {}
+
+    /**
+     * Fire the alarm at epochSeconds, at most a month in the future because
+     * the alarm matches the day of the month, but not the month.
+     */
+    void setAlarm(ace_time::acetime_t epochSeconds) {
+      ace_time::LocalDateTime ldt =
+          ace_time::LocalDateTime::forEpochSeconds(epochSeconds);
+
+      // A1M1-A1M4 are 0, so the alarm matches the date, hours, minutes and
+      // seconds. Bit 6 of the hours is 0 for the 24-hour format, and bit 6
+      // of the date is 0 to match the day of the month.
+      mWireInterface.beginTransmission(kAddress);
+      mWireInterface.write(kAlarm1Register);
+      mWireInterface.write(ace_common::decToBcd(ldt.second()));
+      mWireInterface.write(ace_common::decToBcd(ldt.minute()));
+      mWireInterface.write(ace_common::decToBcd(ldt.hour()));
+      mWireInterface.write(ace_common::decToBcd(ldt.day()));
+      mWireInterface.endTransmission();
+
+      // Route the alarm to the INT pin instead of the square wave.
+      uint8_t control = readRegister(kControlRegister);
+      writeRegister(kControlRegister, control | kControlIntcn | kControlA1ie);
+      clearAlarm();
+    }
+
+    /** Clear the alarm flag, which releases the INT pin. */
+    void clearAlarm() {
+      uint8_t status = readRegister(kStatusRegister);
+      writeRegister(kStatusRegister, status & ~kStatusA1f);
+    }
+
+    /** Disable the alarm interrupt, and clear the alarm flag. */
+    void disableAlarm() {
+      uint8_t control = readRegister(kControlRegister);
+      writeRegister(kControlRegister, control & ~kControlA1ie);
+      clearAlarm();
+    }
+
+  private:
+    static uint8_t const kAlarm1Register = 0x07;
+    static uint8_t const kControlRegister = 0x0E;
+    static uint8_t const kStatusRegister = 0x0F;
+
+    static uint8_t const kControlIntcn = 0x04;
+    static uint8_t const kControlA1ie = 0x01;
+    static uint8_t const kStatusA1f = 0x01;
+
+    uint8_t readRegister(uint8_t reg) {
+      mWireInterface.beginTransmission(kAddress);
+      mWireInterface.write(reg);
+      mWireInterface.endTransmission();
+
+      mWireInterface.requestFrom(kAddress, (uint8_t) 1);
+      uint8_t value = mWireInterface.read();
+      mWireInterface.endRequest();
+      return value;
+    }
+
+    void writeRegister(uint8_t reg, uint8_t value) {
+      mWireInterface.beginTransmission(kAddress);
+      mWireInterface.write(reg);
+      mWireInterface.write(value);
+      mWireInterface.endTransmission();
+    }
+
+    T_WIREI& mWireInterface;
+};
+
+#endif
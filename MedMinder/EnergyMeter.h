@@ -0,0 +1,167 @@
+#ifndef MED_MINDER_ENERGY_METER_H
+#define MED_MINDER_ENERGY_METER_H
+
+#include <Arduino.h> // Print
+#include <AceTime.h> // acetime_t
+#include "config.h"
+
+/**
+ * Accumulates the time spent in each RunMode, and converts it,
+ * along with the counts of I2C transactions, OLED bytes and EEPROM bytes
+ * written, into the charge drawn from the battery, using the ENERGY_XXX
+ * constants of config.h.
+ *
+ * The millis() of the AVR stop during LowPower.powerDown(), so the time
+ * asleep is measured with the RTC by startSleep() and stopSleep(). The time of
+ * each RunMode is kept in whole seconds plus the remaining millis, so that it
+ * does not overflow on a device which runs for months. The counts
+ * are cumulative totals kept by the components themselves, and are passed in
+ * as a Counts snapshot when the estimate is printed.
+ */
+class EnergyMeter {
+  public:
+    /** Traffic counters of the components. */
+    struct Counts {
+      uint32_t i2cTransactions;
+      uint32_t oledBytes;
+      uint32_t eepromBytes;
+    };
+
+    /** Number of RunModes. */
+    static uint8_t const kNumRunModes = 4;
+
+    /** Switch to runMode at nowMillis. */
+    void setRunMode(RunMode runMode, uint32_t nowMillis) {
+      uint32_t elapsedMillis = nowMillis - mLastMillis;
+      addMillis((uint8_t) mRunMode, elapsedMillis);
+      if (mIsSleeping
+          && (mRunMode == RunMode::kSleeping
+              || mRunMode == RunMode::kDreaming)) {
+        mSleepSeenMillis += elapsedMillis;
+      }
+      mRunMode = runMode;
+      mLastMillis = nowMillis;
+    }
+
+    /** Start sleeping, at rtcSeconds of the RTC. */
+    void startSleep(ace_time::acetime_t rtcSeconds, uint32_t nowMillis) {
+      setRunMode(RunMode::kSleeping, nowMillis);
+      mIsSleeping = true;
+      mSleepStartSeconds = rtcSeconds;
+      mSleepSeenMillis = 0;
+    }
+
+    /**
+     * Stop sleeping, at rtcSeconds of the RTC. The time asleep which millis()
+     * did not see is added to RunMode::kSleeping.
+     */
+    void stopSleep(ace_time::acetime_t rtcSeconds, uint32_t nowMillis) {
+      setRunMode(RunMode::kAwake, nowMillis);
+      mIsSleeping = false;
+      if (rtcSeconds <= mSleepStartSeconds) return;
+
+      uint32_t elapsedSeconds = rtcSeconds - mSleepStartSeconds;
+      uint32_t seenSeconds = mSleepSeenMillis / 1000;
+      uint16_t seenMillis = mSleepSeenMillis % 1000;
+      if (elapsedSeconds <= seenSeconds) return;
+
+      uint8_t sleeping = (uint8_t) RunMode::kSleeping;
+      if (seenMillis == 0) {
+        mSeconds[sleeping] += elapsedSeconds - seenSeconds;
+      } else {
+        mSeconds[sleeping] += elapsedSeconds - seenSeconds - 1;
+        addMillis(sleeping, 1000 - seenMillis);
+      }
+    }
+
+    /** Seconds spent in runMode, up to the last setRunMode(). */
+    float secondsIn(RunMode runMode) const {
+      uint8_t i = (uint8_t) runMode;
+      return mSeconds[i] + mMillis[i] / 1000.0f;
+    }
+
+    /** Charge drawn since the start, in nanocoulombs (uA*ms). */
+    float nanocoulombs(const Counts& counts) const {
+      float charge = 0;
+      for (uint8_t i = 0; i < kNumRunModes; ++i) {
+        charge += secondsIn((RunMode) i) * 1000 * microamps((RunMode) i);
+      }
+      charge += (float) counts.i2cTransactions
+          * ENERGY_I2C_TRANSACTION_NANOCOULOMBS;
+      charge += (float) counts.oledBytes * ENERGY_OLED_BYTE_NANOCOULOMBS;
+      charge += (float) counts.eepromBytes * ENERGY_EEPROM_BYTE_NANOCOULOMBS;
+      return charge;
+    }
+
+    /** Average charge per day, in mAh, over the accumulated time. */
+    float milliampHoursPerDay(const Counts& counts) const {
+      float totalSeconds = 0;
+      for (uint8_t i = 0; i < kNumRunModes; ++i) {
+        totalSeconds += secondsIn((RunMode) i);
+      }
+      if (totalSeconds == 0) return 0;
+
+      // 1 mAh = 3.6e9 nC
+      return nanocoulombs(counts) / 3.6e9 * (86400 / totalSeconds);
+    }
+
+    /**
+     * Print the time in each RunMode, the counts, the estimated mAh per day
+     * and the battery life in days, one "name: value" per line.
+     */
+    void printTo(Print& printer, const Counts& counts) const {
+      printer.print(F("awakeSeconds: "));
+      printer.println(secondsIn(RunMode::kAwake)
+          + secondsIn(RunMode::kReminding), 3);
+      printer.print(F("dreamingSeconds: "));
+      printer.println(secondsIn(RunMode::kDreaming), 3);
+      printer.print(F("sleepingSeconds: "));
+      printer.println(secondsIn(RunMode::kSleeping), 3);
+      printer.print(F("i2cTransactions: "));
+      printer.println(counts.i2cTransactions);
+      printer.print(F("oledBytes: "));
+      printer.println(counts.oledBytes);
+      printer.print(F("eepromBytes: "));
+      printer.println(counts.eepromBytes);
+
+      float perDay = milliampHoursPerDay(counts);
+      printer.print(F("milliampHoursPerDay: "));
+      printer.println(perDay, 3);
+      printer.print(F("batteryDays: "));
+      printer.println(perDay > 0 ? BATTERY_MILLIAMP_HOURS / perDay : 0, 1);
+    }
+
+  private:
+    static uint16_t microamps(RunMode runMode) {
+      switch (runMode) {
+        case RunMode::kSleeping:
+          return ENERGY_SLEEPING_MICROAMPS;
+        case RunMode::kDreaming:
+          return ENERGY_DREAMING_MICROAMPS;
+        default:
+          return ENERGY_AWAKE_MICROAMPS;
+      }
+    }
+
+    /** Add elapsedMillis to the time of the RunMode at index i. */
+    void addMillis(uint8_t i, uint32_t elapsedMillis) {
+      mSeconds[i] += elapsedMillis / 1000;
+      mMillis[i] += elapsedMillis % 1000;
+      if (mMillis[i] >= 1000) {
+        mMillis[i] -= 1000;
+        mSeconds[i]++;
+      }
+    }
+
+    uint32_t mSeconds[kNumRunModes] = {};
+    uint16_t mMillis[kNumRunModes] = {};
+    RunMode mRunMode = RunMode::kAwake;
+    uint32_t mLastMillis = 0;
+    bool mIsSleeping = false;
+    ace_time::acetime_t mSleepStartSeconds = 0;
+
+    /** Millis seen by millis() asleep or dreaming, since startSleep(). */
+    uint32_t mSleepSeenMillis = 0;
+};
+
+#endif
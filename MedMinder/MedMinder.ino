@@ -7,6 +7,15 @@
  * TimeZone is either a UTC offset plus a DST flag, or a TimeZone identifier
  * (e.g. "Los_Angeles" or "Denver").
  *
+ * Up to NUM_MEDS meds have their own interval and countdown. The Mode button
+ * shows each med in turn before the next screen, and a med whose interval is
+ * 00:00 is off. The meds are kept in a MedQueue by due time, and the first
+ * med due is shown after a wake up.
+ *
+ * If ENABLE_ALARM_WAKE is set, the Alarm 1 of the DS3231 wakes up the clock
+ * from sleep when the first med is due, which flashes a short reminder then goes
+ * back to sleep. `make simulate` estimates the resulting battery life.
+ *
  * The hardware dependencies are:
  *
  *    * Arduino Pro Mini
@@ -63,7 +72,13 @@
 #endif
 #include "Presenter.h"
 #include "PersistentStore.h"
+#include "DoseLog.h"
 #include "Controller.h"
+#include "Benchmark.h"
+#include "Ds3231Alarm.h"
+#include "CountingWireInterface.h"
+#include "EnergyMeter.h"
+#include "SSD1306AsciiCounter.h"
 
 using namespace ace_button;
 using namespace ace_routine;
@@ -73,13 +88,18 @@ using namespace ace_time;
 // Configure PersistentStore
 //------------------------------------------------------------------
 
-const uint32_t kContextId = 0x9b2ddeca; // random contextId
+// Random contextId, changed whenever the layout of the StoredInfo changes.
+const uint32_t kContextId = 0x5e17a3c2;
 const uint16_t kStoredInfoEepromAddress = 0;
 
 PersistentStore persistentStore(kContextId, kStoredInfoEepromAddress);
 
+// The DoseLog follows the StoredInfo slots in the EEPROM.
+DoseLog doseLog(persistentStore.storedSize());
+
 void setupPersistentStore() {
   persistentStore.setup();
+  doseLog.setup();
 }
 
 //-----------------------------------------------------------------------------
@@ -154,8 +174,17 @@ static ManualZoneManager zoneManager;
 //------------------------------------------------------------------
 
 #if TIME_PROVIDER == TIME_PROVIDER_DS3231
-  using WireInterface = ace_wire::TwoWireInterface<TwoWire>;
-  WireInterface wireInterface(Wire);
+  #if ENABLE_ENERGY_METER
+    // Count the I2C transactions of the DS3231 for the EnergyMeter.
+    uint32_t numRtcTransactions = 0;
+    ace_wire::TwoWireInterface<TwoWire> twoWireInterface(Wire);
+    using WireInterface =
+        CountingWireInterface<ace_wire::TwoWireInterface<TwoWire>>;
+    WireInterface wireInterface(twoWireInterface, numRtcTransactions);
+  #else
+    using WireInterface = ace_wire::TwoWireInterface<TwoWire>;
+    WireInterface wireInterface(Wire);
+  #endif
   DS3231Clock<WireInterface> dsClock(wireInterface);
   SystemClockCoroutine systemClock(&dsClock /*reference*/, &dsClock /*backup*/);
 #elif TIME_PROVIDER == TIME_PROVIDER_NTP
@@ -179,6 +208,15 @@ void setupClocks() {
 //------------------------------------------------------------------
 
 SSD1306AsciiWire oled;
+#if ENABLE_DISPLAY_COUNTER
+  SSD1306AsciiCounter oledCounter(oled);
+  SSD1306Ascii& oledBus = oledCounter;
+#else
+  SSD1306Ascii& oledBus = oled;
+#endif
+#if ENABLE_OLED_SHADOW
+  SSD1306AsciiShadow oledShadow(oledBus);
+#endif
 
 void setupOled() {
   oled.begin(&Adafruit128x64, OLED_I2C_ADDRESS);
@@ -186,15 +224,53 @@ void setupOled() {
   oled.setFont(fixed_bold10x15);
   oled.clear();
   oled.setScrollMode(false);
+#if ENABLE_DISPLAY_COUNTER
+  oledCounter.begin(&Adafruit128x64);
+  oledCounter.setScrollMode(false);
+#endif
+#if ENABLE_OLED_SHADOW
+  oledShadow.begin(&Adafruit128x64);
+  oledShadow.setScrollMode(false);
+#endif
 }
 
+//------------------------------------------------------------------
+// Energy accounting.
+//------------------------------------------------------------------
+
+#if ENABLE_ENERGY_METER
+  #if ! ENABLE_DISPLAY_COUNTER
+    #error ENABLE_ENERGY_METER requires ENABLE_DISPLAY_COUNTER
+  #endif
+
+EnergyMeter energyMeter;
+
+// Collect the traffic counters of the OLED, the DS3231 and the EEPROM.
+EnergyMeter::Counts readEnergyCounts() {
+  const SSD1306AsciiCounter::Traffic& traffic = oledCounter.traffic();
+  EnergyMeter::Counts counts;
+  counts.i2cTransactions = traffic.transactions;
+#if TIME_PROVIDER == TIME_PROVIDER_DS3231
+  counts.i2cTransactions += numRtcTransactions;
+#endif
+  counts.oledBytes = traffic.bytes;
+  counts.eepromBytes = persistentStore.numBytesWritten()
+      + doseLog.numBytesWritten();
+  return counts;
+}
+#endif
+
 //------------------------------------------------------------------
 // Configure the controller.
 //------------------------------------------------------------------
 
-Presenter presenter(zoneManager, oled);
-Controller controller(systemClock, persistentStore, presenter, zoneManager,
-    DISPLAY_ZONE);
+#if ENABLE_OLED_SHADOW
+  Presenter presenter(zoneManager, oledShadow);
+#else
+  Presenter presenter(zoneManager, oledBus);
+#endif
+Controller controller(systemClock, persistentStore, doseLog, presenter,
+    zoneManager, DISPLAY_ZONE);
 
 void setupController() {
   controller.setup();
@@ -223,14 +299,14 @@ COROUTINE(blinker) {
 // Sleep Manager
 //------------------------------------------------------------------
 
-enum class RunMode : uint8_t {
-  kAwake,
-  kSleeping,
-  kDreaming,
-};
+const uint16_t SLEEP_DELAY_MILLIS = 5000;
 
 static uint16_t lastUserActionMillis;
 
+// Milliseconds to stay awake after lastUserActionMillis. Shorter after a wake
+// by the alarm, until a button is pressed.
+static uint16_t sleepDelayMillis = SLEEP_DELAY_MILLIS;
+
 #if ENABLE_LOW_POWER == 1
 volatile RunMode runMode = RunMode::kAwake;
 
@@ -238,29 +314,73 @@ void buttonInterrupt() {
   runMode = RunMode::kAwake;
 }
 
-const uint16_t SLEEP_DELAY_MILLIS = 5000;
+#if ENABLE_ALARM_WAKE
+  #if TIME_PROVIDER != TIME_PROVIDER_DS3231
+    #error ENABLE_ALARM_WAKE requires TIME_PROVIDER_DS3231
+  #endif
+
+Ds3231Alarm<WireInterface> ds3231Alarm(wireInterface);
+
+void alarmInterrupt() {
+  runMode = RunMode::kReminding;
+}
+#endif
 
 static bool isWakingUp;
 
+#if ENABLE_ENERGY_METER
+// Account the sleep which just ended, using the SystemClock synced by the
+// wakeup of the Controller, then dump the estimate if debugging.
+void stopSleepMeter() {
+  energyMeter.stopSleep(systemClock.getNow(), millis());
+  if (ENABLE_SERIAL_DEBUG) {
+    energyMeter.printTo(SERIAL_PORT_MONITOR, readEnergyCounts());
+  }
+}
+#endif
+
 COROUTINE(manageSleep) {
   COROUTINE_LOOP() {
-    // Go to sleep if more than 5 seconds passes after the last user action.
+    // Go to sleep if more than sleepDelayMillis passes after the last user
+    // action.
     COROUTINE_AWAIT((uint16_t) ((uint16_t) millis() - lastUserActionMillis)
-        >= SLEEP_DELAY_MILLIS);
-    controller.prepareToSleep();
+        >= sleepDelayMillis);
+    // Render the frame of the expected wake up before powering down.
+  #if ENABLE_ALARM_WAKE
+    {
+      acetime_t nowSeconds = systemClock.getNow();
+      acetime_t alarmSeconds = controller.nextReminderSeconds(nowSeconds);
+      controller.prepareToSleep(nowSeconds, alarmSeconds);
+      if (alarmSeconds == LocalDate::kInvalidEpochSeconds) {
+        // No med is scheduled, so only a button can wake up.
+        ds3231Alarm.disableAlarm();
+      } else {
+        ds3231Alarm.setAlarm(alarmSeconds);
+      }
+    }
+  #else
+    controller.prepareToSleep(
+        systemClock.getNow(), LocalDate::kInvalidEpochSeconds);
+  #endif
     if (ENABLE_SERIAL_DEBUG) {
       SERIAL_PORT_MONITOR.println("Powering down");
       COROUTINE_DELAY(500);
     }
 
+  #if ENABLE_ENERGY_METER
+    energyMeter.startSleep(systemClock.getNow(), millis());
+  #endif
     runMode = RunMode::kSleeping;
     // What happens if a button is pressed right here?
     while (true) {
       isWakingUp = false;
+    #if ENABLE_ENERGY_METER
+      energyMeter.setRunMode(RunMode::kSleeping, millis());
+    #endif
       LowPower.powerDown(SLEEP_FOREVER, ADC_OFF, BOD_OFF);
 
-      // Check if button caused wakeup.
-      if (runMode == RunMode::kAwake) break;
+      // Check if button or alarm caused wakeup.
+      if (runMode == RunMode::kAwake || runMode == RunMode::kReminding) break;
 
       isWakingUp = true;
       if (ENABLE_SERIAL_DEBUG) {
@@ -269,12 +389,34 @@ COROUTINE(manageSleep) {
         COROUTINE_DELAY(500);
       }
       runMode = RunMode::kDreaming;
+    #if ENABLE_ENERGY_METER
+      energyMeter.setRunMode(RunMode::kDreaming, millis());
+    #endif
       COROUTINE_DELAY(250);
     }
 
     if (ENABLE_SERIAL_DEBUG) SERIAL_PORT_MONITOR.println("Powering up");
+  #if ENABLE_ALARM_WAKE
+    ds3231Alarm.clearAlarm();
+    if (runMode == RunMode::kReminding) {
+      // No button to eat. Flash the reminder briefly, then sleep again.
+      runMode = RunMode::kAwake;
+      controller.wakeupForReminder();
+    #if ENABLE_ENERGY_METER
+      stopSleepMeter();
+    #endif
+      isWakingUp = false;
+      sleepDelayMillis = REMINDER_FLASH_MILLIS;
+      lastUserActionMillis = millis();
+      continue;
+    }
+  #endif
     controller.wakeup();
+  #if ENABLE_ENERGY_METER
+    stopSleepMeter();
+  #endif
     isWakingUp = true;
+    sleepDelayMillis = SLEEP_DELAY_MILLIS;
     lastUserActionMillis = millis();
   }
 }
@@ -291,6 +433,7 @@ AceButton changeButton(&buttonConfig, CHANGE_BUTTON_PIN);
 void handleButton(AceButton* button, uint8_t eventType,
     uint8_t /* buttonState */) {
   lastUserActionMillis = millis();
+  sleepDelayMillis = SLEEP_DELAY_MILLIS;
   uint8_t pin = button->getPin();
 
   if (pin == CHANGE_BUTTON_PIN) {
@@ -371,6 +514,313 @@ void setupAceButton() {
   buttonConfig.setRepeatPressInterval(150);
 }
 
+//-----------------------------------------------------------------------------
+// Benchmark the Controller and the Presenter in each Mode.
+//-----------------------------------------------------------------------------
+
+#if ENABLE_BENCHMARK
+
+static const uint16_t BENCHMARK_ITERATIONS = 100;
+
+// Stop if the Mode button never cycles back to the first Mode.
+static const uint8_t BENCHMARK_MAX_MODES = 64;
+
+// Start of the clock in each Mode.
+static acetime_t benchmarkStartSeconds;
+
+// Set if the steady-state display traffic exceeds its budget.
+static bool benchmarkOverBudget = false;
+
+// Highest steady-state display traffic of the view Modes, in bytes per second.
+static uint32_t benchmarkMaxViewBytesPerSecond = 0;
+
+#if ENABLE_DISPLAY_COUNTER
+// Print the OLED traffic per second after the first iteration, and check it
+// against the DISPLAY_BYTES_PER_SECOND_BUDGET.
+void printBenchmarkTraffic(uint8_t mode, bool checkBudget) {
+  uint16_t seconds = BENCHMARK_ITERATIONS - 1;
+  const SSD1306AsciiCounter::Traffic& traffic = oledCounter.traffic();
+  BenchmarkTimer::printLineTo(SERIAL_PORT_MONITOR, F("MedMinder"), mode,
+      F("busTransactionsPerSecond"), seconds, traffic.transactions / seconds);
+  BenchmarkTimer::printLineTo(SERIAL_PORT_MONITOR, F("MedMinder"), mode,
+      F("busCursorMovesPerSecond"), seconds, traffic.cursorMoves / seconds);
+  BenchmarkTimer::printLineTo(SERIAL_PORT_MONITOR, F("MedMinder"), mode,
+      F("busBytesPerSecond"), seconds, traffic.bytes / seconds);
+
+  if (checkBudget) {
+    uint32_t bytesPerSecond = traffic.bytes / seconds;
+    if (bytesPerSecond > benchmarkMaxViewBytesPerSecond) {
+      benchmarkMaxViewBytesPerSecond = bytesPerSecond;
+    }
+    if (bytesPerSecond > DISPLAY_BYTES_PER_SECOND_BUDGET) {
+      benchmarkOverBudget = true;
+    }
+  }
+}
+#endif
+
+// Time each operation BENCHMARK_ITERATIONS times in the current Mode, with the
+// SystemClock advanced by 1 second before each iteration.
+// The update is the Controller alone, and each render is timed by
+// updateDisplay, after both the update and the blink.
+void benchmarkMode(bool isViewMode) {
+  BenchmarkTimer updateTimer;
+  BenchmarkTimer blinkTimer;
+  BenchmarkTimer displayTimer;
+
+  for (uint16_t i = 0; i < BENCHMARK_ITERATIONS; ++i) {
+    systemClock.setNow(benchmarkStartSeconds + i);
+    updateTimer.start();
+    controller.updateClockInfo();
+    updateTimer.stop();
+    displayTimer.start();
+    presenter.updateDisplay();
+    displayTimer.stop();
+    blinkTimer.start();
+    controller.updateBlinkState();
+    blinkTimer.stop();
+    displayTimer.start();
+    presenter.updateDisplay();
+    displayTimer.stop();
+
+  #if ENABLE_DISPLAY_COUNTER
+    // The first iteration redraws the whole screen of the new Mode.
+    if (i == 0) oledCounter.resetTraffic();
+  #endif
+  }
+
+  uint8_t mode = (uint8_t) controller.getMode();
+  updateTimer.printTo(
+      SERIAL_PORT_MONITOR, F("MedMinder"), mode, F("update"));
+  blinkTimer.printTo(
+      SERIAL_PORT_MONITOR, F("MedMinder"), mode, F("updateBlinkState"));
+  displayTimer.printTo(
+      SERIAL_PORT_MONITOR, F("MedMinder"), mode, F("updateDisplay"));
+#if ENABLE_DISPLAY_COUNTER
+  printBenchmarkTraffic(mode, isViewMode);
+#else
+  (void) isViewMode;
+#endif
+}
+
+// Offsets of the simulated wake ups from the time of sleep. The alarm is set
+// 6 hours after the sleep, and the button is pressed at an arbitrary time
+// before it.
+static const int32_t BENCHMARK_ALARM_SECONDS = 6 * 3600;
+static const int32_t BENCHMARK_BUTTON_SECONDS = 2 * 3600 + 17 * 60 + 23;
+
+// Time the wake ups from sleep, with the reminder frame of the alarm rendered
+// into the OLED before sleeping.
+//
+// The alarm wake (reminderWakeToCorrected) turns on the display showing the
+// reminder frame, then reads the clock and corrects the frame. Its
+// reminderWakeBytes should be only the 1 byte of the command which turns on
+// the display.
+//
+// The button wake (buttonWakeToPixels) reads the clock and redraws the
+// reminder frame into the current Mode at the time of the press, while the
+// display is still off, then turns it on. The buttonWakeBytes are that
+// redraw, which is never visible.
+void benchmarkWakeup(acetime_t startSeconds) {
+  BenchmarkTimer buttonTimer;
+  BenchmarkTimer reminderTimer;
+  uint32_t buttonBytes = 0;
+  uint32_t reminderBytes = 0;
+  for (uint16_t i = 0; i < BENCHMARK_ITERATIONS; ++i) {
+    acetime_t sleepSeconds = startSeconds + i * (int32_t) 60;
+    acetime_t alarmSeconds = sleepSeconds + BENCHMARK_ALARM_SECONDS;
+
+    controller.prepareToSleep(sleepSeconds, alarmSeconds);
+    systemClock.setNow(sleepSeconds + BENCHMARK_BUTTON_SECONDS);
+  #if ENABLE_DISPLAY_COUNTER
+    oledCounter.resetTraffic();
+  #endif
+    buttonTimer.start();
+    controller.wakeup();
+    buttonTimer.stop();
+  #if ENABLE_DISPLAY_COUNTER
+    buttonBytes += oledCounter.traffic().bytes;
+  #endif
+  }
+  uint8_t mode = (uint8_t) controller.getMode();
+  buttonTimer.printTo(
+      SERIAL_PORT_MONITOR, F("MedMinder"), mode, F("buttonWakeToPixels"));
+#if ENABLE_DISPLAY_COUNTER
+  BenchmarkTimer::printLineTo(SERIAL_PORT_MONITOR, F("MedMinder"), mode,
+      F("buttonWakeBytes"), BENCHMARK_ITERATIONS,
+      buttonBytes / BENCHMARK_ITERATIONS);
+#endif
+
+  for (uint16_t i = 0; i < BENCHMARK_ITERATIONS; ++i) {
+    acetime_t sleepSeconds = startSeconds + i * (int32_t) 60;
+    acetime_t alarmSeconds = sleepSeconds + BENCHMARK_ALARM_SECONDS;
+
+    controller.prepareToSleep(sleepSeconds, alarmSeconds);
+    systemClock.setNow(alarmSeconds);
+  #if ENABLE_DISPLAY_COUNTER
+    oledCounter.resetTraffic();
+  #endif
+    reminderTimer.start();
+    controller.wakeupForReminder();
+    reminderTimer.stop();
+  #if ENABLE_DISPLAY_COUNTER
+    reminderBytes += oledCounter.traffic().bytes;
+  #endif
+  }
+  mode = (uint8_t) controller.getMode();
+  reminderTimer.printTo(
+      SERIAL_PORT_MONITOR, F("MedMinder"), mode, F("reminderWakeToCorrected"));
+#if ENABLE_DISPLAY_COUNTER
+  BenchmarkTimer::printLineTo(SERIAL_PORT_MONITOR, F("MedMinder"), mode,
+      F("reminderWakeBytes"), BENCHMARK_ITERATIONS,
+      reminderBytes / BENCHMARK_ITERATIONS);
+#endif
+}
+
+// Benchmark each Mode, then restore the clock and the StoredInfo changed by
+// the walk through the Modes.
+void runBenchmark() {
+  benchmarkStartSeconds =
+      LocalDateTime::forComponents(2025, 1, 1, 0, 0, 0).toEpochSeconds();
+  acetime_t savedSeconds = systemClock.getNow();
+  uint32_t savedMillis = millis();
+  BenchmarkTimer::printHeaderTo(SERIAL_PORT_MONITOR);
+
+  benchmarkModes(controller, benchmarkMode, BENCHMARK_MAX_MODES);
+
+  // Drop the StoredInfo saved by the walk, before prepareToSleep() flushes it.
+  persistentStore.discard();
+  benchmarkWakeup(benchmarkStartSeconds);
+
+  // Restore the clock moved by the benchmark.
+  if (savedSeconds != LocalDateTime::kInvalidEpochSeconds) {
+    systemClock.setNow(savedSeconds + (millis() - savedMillis) / 1000);
+  }
+
+  SERIAL_PORT_MONITOR.print(F("# Max view Mode busBytesPerSecond: "));
+  SERIAL_PORT_MONITOR.print(benchmarkMaxViewBytesPerSecond);
+  SERIAL_PORT_MONITOR.print(F("; DISPLAY_BYTES_PER_SECOND_BUDGET: "));
+  SERIAL_PORT_MONITOR.println(DISPLAY_BYTES_PER_SECOND_BUDGET);
+  if (benchmarkOverBudget) {
+    SERIAL_PORT_MONITOR.println(
+        F("# Warning: display traffic exceeds "
+          "DISPLAY_BYTES_PER_SECOND_BUDGET"));
+  }
+
+#if defined(EPOXY_DUINO)
+  exit(0);
+#endif
+}
+
+#endif
+
+//-----------------------------------------------------------------------------
+// Simulate the sleep and reminder cycle to estimate the battery life.
+//-----------------------------------------------------------------------------
+
+#if ENABLE_POWER_SIMULATION
+
+static const uint16_t SIMULATION_DAYS = 30;
+
+// The user takes each dose this long after it is due, and spends this long
+// pressing the buttons to do it, followed by the SLEEP_DELAY_MILLIS.
+static const int32_t SIMULATION_DOSE_DELAY_SECONDS = 40 * 60;
+static const uint32_t SIMULATION_DOSE_MILLIS = 10000;
+
+// Wake up at nowSeconds, either by a button to take a dose with a long press
+// of the Change button in Mode::kViewMed, or by the alarm to flash a
+// reminder, then go back to sleep. The EnergyMeter runs on the simulated
+// millis since startSeconds. The SystemClock::setNow() adds 1 I2C transaction
+// to the DS3231 per wake up, which the real clock does not do.
+void simulateWakeup(acetime_t startSeconds, acetime_t nowSeconds,
+    bool takeDose) {
+  uint32_t wakeMillis = (nowSeconds - startSeconds) * (uint32_t) 1000;
+  uint32_t awakeMillis;
+  systemClock.setNow(nowSeconds);
+  energyMeter.setRunMode(RunMode::kAwake, wakeMillis);
+
+  if (takeDose) {
+    controller.wakeup();
+    for (uint8_t i = 0; i < 8 && controller.getMode() != Mode::kViewMed; ++i) {
+      controller.handleModeButtonPress();
+    }
+    controller.handleChangeButtonLongPress();
+    awakeMillis = SIMULATION_DOSE_MILLIS + SLEEP_DELAY_MILLIS;
+  } else {
+    controller.wakeupForReminder();
+    awakeMillis = REMINDER_FLASH_MILLIS;
+  }
+
+  controller.prepareToSleep(
+      nowSeconds, controller.nextReminderSeconds(nowSeconds));
+  energyMeter.setRunMode(RunMode::kSleeping, wakeMillis + awakeMillis);
+}
+
+// Step through SIMULATION_DAYS of reminders from the alarm of the RTC, and of
+// doses taken SIMULATION_DOSE_DELAY_SECONDS after they are due, and print the
+// estimate of the EnergyMeter.
+void runPowerSimulation() {
+  acetime_t startSeconds =
+      LocalDateTime::forComponents(2025, 1, 1, 8, 0, 0).toEpochSeconds();
+  acetime_t endSeconds = startSeconds + SIMULATION_DAYS * (int32_t) 86400;
+
+  // Count only the traffic of the simulation.
+  energyMeter = EnergyMeter();
+  oledCounter.resetTraffic();
+#if TIME_PROVIDER == TIME_PROVIDER_DS3231
+  numRtcTransactions = 0;
+#endif
+  EnergyMeter::Counts startCounts = readEnergyCounts();
+
+  acetime_t nowSeconds = startSeconds;
+  simulateWakeup(startSeconds, nowSeconds, true /*takeDose*/);
+  acetime_t doseSeconds = controller.nextReminderSeconds(nowSeconds)
+      + SIMULATION_DOSE_DELAY_SECONDS;
+  uint32_t numReminders = 0;
+  uint32_t numDoses = 1;
+  while (true) {
+    acetime_t reminderSeconds = controller.nextReminderSeconds(nowSeconds);
+    if (reminderSeconds == LocalDate::kInvalidEpochSeconds) break;
+    bool takeDose = doseSeconds <= reminderSeconds;
+    nowSeconds = takeDose ? doseSeconds : reminderSeconds;
+    // Leave room for the awake time of the last wake up.
+    if (nowSeconds >= endSeconds - 60) break;
+
+    simulateWakeup(startSeconds, nowSeconds, takeDose);
+    if (takeDose) {
+      numDoses++;
+      doseSeconds = controller.nextReminderSeconds(nowSeconds)
+          + SIMULATION_DOSE_DELAY_SECONDS;
+    } else {
+      numReminders++;
+    }
+  }
+  energyMeter.setRunMode(RunMode::kAwake,
+      (endSeconds - startSeconds) * (uint32_t) 1000);
+
+  EnergyMeter::Counts counts = readEnergyCounts();
+  counts.eepromBytes -= startCounts.eepromBytes;
+
+  SERIAL_PORT_MONITOR.print(F("days: "));
+  SERIAL_PORT_MONITOR.println(SIMULATION_DAYS);
+  SERIAL_PORT_MONITOR.print(F("doses: "));
+  SERIAL_PORT_MONITOR.println(numDoses);
+  SERIAL_PORT_MONITOR.print(F("reminders: "));
+  SERIAL_PORT_MONITOR.println(numReminders);
+  SERIAL_PORT_MONITOR.print(F("awakeMillisPerDay: "));
+  SERIAL_PORT_MONITOR.println((uint32_t)
+      ((energyMeter.secondsIn(RunMode::kAwake)
+          + energyMeter.secondsIn(RunMode::kReminding))
+      * 1000 / SIMULATION_DAYS));
+  energyMeter.printTo(SERIAL_PORT_MONITOR, counts);
+
+#if defined(EPOXY_DUINO)
+  exit(0);
+#endif
+}
+
+#endif
+
 //------------------------------------------------------------------
 // MedMinder main loop
 //------------------------------------------------------------------
@@ -386,11 +836,11 @@ void setup() {
   TXLED0; // LED off
 #endif
 
-  if (ENABLE_SERIAL_DEBUG) {
+  if (ENABLE_SERIAL_DEBUG || ENABLE_BENCHMARK || ENABLE_POWER_SIMULATION) {
     SERIAL_PORT_MONITOR.begin(115200);
     while (!SERIAL_PORT_MONITOR); // Wait until Serial is ready - Leonardo/Micro
-    SERIAL_PORT_MONITOR.println(F("setup(): begin"));
   }
+  if (ENABLE_SERIAL_DEBUG) SERIAL_PORT_MONITOR.println(F("setup(): begin"));
 
   Wire.begin();
   Wire.setClock(400000L);
@@ -401,9 +851,21 @@ void setup() {
   setupOled();
   setupController();
 
+#if ENABLE_BENCHMARK
+  runBenchmark();
+#endif
+#if ENABLE_POWER_SIMULATION
+  runPowerSimulation();
+#endif
+
 #if ENABLE_LOW_POWER == 1
   enableInterrupt(MODE_BUTTON_PIN, buttonInterrupt, CHANGE);
   enableInterrupt(CHANGE_BUTTON_PIN, buttonInterrupt, CHANGE);
+  #if ENABLE_ALARM_WAKE
+    // The INT pin of the DS3231 is open-drain, active low.
+    pinMode(ALARM_INTERRUPT_PIN, INPUT_PULLUP);
+    enableInterrupt(ALARM_INTERRUPT_PIN, alarmInterrupt, FALLING);
+  #endif
 #endif
 
   lastUserActionMillis = millis();
@@ -420,4 +882,6 @@ void loop() {
   // bytes of flash, and 31 bytes of SRAM.
   modeButton.check();
   changeButton.check();
+
+  persistentStore.loop();
 }
@@ -0,0 +1,102 @@
+#ifndef MED_MINDER_MED_QUEUE_H
+#define MED_MINDER_MED_QUEUE_H
+
+#include <stdint.h>
+#include <AceTime.h> // acetime_t
+
+/**
+ * A fixed-capacity binary min-heap of the enabled meds, keyed by the time when
+ * each med is next due. The most urgent med is always at top(), so that the
+ * Controller and the sleep manager look only at the head, instead of scanning
+ * every schedule. A med appears at most once, and update() moves it to its
+ * new place when its due time changes, in O(log CAPACITY).
+ */
+template <uint8_t CAPACITY>
+class MedQueue {
+  public:
+    /** A med and the time when it is next due. */
+    struct Entry {
+      ace_time::acetime_t dueTime;
+      uint8_t med;
+    };
+
+    uint8_t size() const { return mSize; }
+
+    bool empty() const { return mSize == 0; }
+
+    /** The med which is due first. Valid only if not empty(). */
+    const Entry& top() const { return mEntries[0]; }
+
+    /** Insert the med with its dueTime, or move it if already queued. */
+    void update(uint8_t med, ace_time::acetime_t dueTime) {
+      uint8_t i = find(med);
+      if (i == mSize) {
+        if (mSize == CAPACITY) return;
+        mSize++;
+      }
+      mEntries[i].dueTime = dueTime;
+      mEntries[i].med = med;
+      siftDown(siftUp(i));
+    }
+
+    /** Remove the med, if queued. */
+    void remove(uint8_t med) {
+      uint8_t i = find(med);
+      if (i == mSize) return;
+      mSize--;
+      if (i == mSize) return;
+      mEntries[i] = mEntries[mSize];
+      siftDown(siftUp(i));
+    }
+
+  private:
+    /** Return the index of the med, or mSize if not queued. */
+    uint8_t find(uint8_t med) const {
+      for (uint8_t i = 0; i < mSize; ++i) {
+        if (mEntries[i].med == med) return i;
+      }
+      return mSize;
+    }
+
+    /** Move the entry at i up while it is due before its parent. */
+    uint8_t siftUp(uint8_t i) {
+      while (i > 0) {
+        uint8_t parent = (i - 1) / 2;
+        if (mEntries[parent].dueTime <= mEntries[i].dueTime) break;
+        swap(i, parent);
+        i = parent;
+      }
+      return i;
+    }
+
+    /** Move the entry at i down while a child is due before it. */
+    void siftDown(uint8_t i) {
+      while (true) {
+        uint8_t smallest = i;
+        uint8_t left = 2 * i + 1;
+        uint8_t right = left + 1;
+        if (left < mSize
+            && mEntries[left].dueTime < mEntries[smallest].dueTime) {
+          smallest = left;
+        }
+        if (right < mSize
+            && mEntries[right].dueTime < mEntries[smallest].dueTime) {
+          smallest = right;
+        }
+        if (smallest == i) return;
+        swap(i, smallest);
+        i = smallest;
+      }
+    }
+
+    void swap(uint8_t a, uint8_t b) {
+      Entry tmp = mEntries[a];
+      mEntries[a] = mEntries[b];
+      mEntries[b] = tmp;
+    }
+
+    Entry mEntries[CAPACITY];
+    uint8_t mSize = 0;
+};
+
+#endif
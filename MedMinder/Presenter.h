@@ -3,6 +3,9 @@
 
 #include "config.h"
 #include <SSD1306AsciiWire.h>
+#if ENABLE_OLED_SHADOW
+  #include "SSD1306AsciiShadow.h"
+#endif
 #include <AceTime.h>
 #include <AceButton.h>
 #include <AceRoutine.h>
@@ -23,7 +26,11 @@ class Presenter {
       #elif TIME_ZONE_TYPE == TIME_ZONE_TYPE_EXTENDED
         ExtendedZoneManager& zoneManager,
       #endif
+    #if ENABLE_OLED_SHADOW
+      SSD1306AsciiShadow& oled
+    #else
       SSD1306Ascii& oled
+    #endif
     ):
         mZoneManager(zoneManager),
         mOled(oled) {}
@@ -40,6 +47,9 @@ class Presenter {
         updateDisplaySettings();
         displayData();
       }
+    #if ENABLE_OLED_SHADOW
+      mOled.flush();
+    #endif
 
       mPrevClockInfo = mClockInfo;
     }
@@ -99,6 +109,10 @@ class Presenter {
           displayMed();
           break;
 
+        case Mode::kViewDoses:
+          displayDoses();
+          break;
+
         case Mode::kViewDateTime:
         case Mode::kChangeYear:
         case Mode::kChangeMonth:
@@ -143,15 +157,66 @@ class Presenter {
         SERIAL_PORT_MONITOR.println(F("displayMed()"));
       }
 
-      mOled.println(F("Med due"));
-      if (mClockInfo.medInterval.isError()) {
+      uint8_t med = mClockInfo.medIndex;
+      printMedName();
+      if (mClockInfo.medIntervals[med].toSeconds() == 0) {
+        mOled.print(F(" off"));
+        clearToEOL();
+        clearToEOL();
+        return;
+      }
+
+      mOled.print(F(" due"));
+      clearToEOL();
+      if (mClockInfo.medRemaining.isError()) {
         mOled.print(F("<Overdue>"));
       } else {
-        mClockInfo.medInterval.printTo(mOled);
+        mClockInfo.medRemaining.printTo(mOled);
       }
       clearToEOL();
     }
 
+    /** Print "Med", followed by the med number if there are several. */
+    void printMedName() const {
+      mOled.print(F("Med"));
+      if (ClockInfo::kNumMeds > 1) {
+        mOled.print(mClockInfo.medIndex + 1);
+      }
+    }
+
+    void displayDoses() const {
+      if (ENABLE_SERIAL_DEBUG >= 1) {
+        SERIAL_PORT_MONITOR.println(F("displayDoses()"));
+      }
+
+      setFont(0);
+      mOled.print(F("Last doses"));
+      clearToEOL();
+      if (mClockInfo.numRecentDoses == 0) {
+        mOled.print(F("<none>"));
+        clearToEOL();
+        return;
+      }
+
+      TimeZone tz = mZoneManager.createForTimeZoneData(mClockInfo.timeZoneData);
+      for (uint8_t i = 0; i < mClockInfo.numRecentDoses; ++i) {
+        ZonedDateTime dateTime = ZonedDateTime::forEpochSeconds(
+            mClockInfo.recentDoses[i], tz);
+        printPad2To(mOled, dateTime.month(), '0');
+        mOled.print('-');
+        printPad2To(mOled, dateTime.day(), '0');
+        mOled.print(' ');
+        printPad2To(mOled, dateTime.hour(), '0');
+        mOled.print(':');
+        printPad2To(mOled, dateTime.minute(), '0');
+        if (ClockInfo::kNumMeds > 1) {
+          mOled.print(F(" Med"));
+          mOled.print(mClockInfo.recentDoseMeds[i] + 1);
+        }
+        clearToEOL();
+      }
+    }
+
     void displayAbout() const {
       if (ENABLE_SERIAL_DEBUG >= 1) {
         SERIAL_PORT_MONITOR.println(F("displayAbout()"));
@@ -167,16 +232,18 @@ class Presenter {
     }
 
     void displayChangeMed() const {
-      mOled.println("Med intrvl");
+      const TimePeriod& interval = mClockInfo.medIntervals[mClockInfo.medIndex];
+      printMedName();
+      mOled.println(F(" intrvl"));
 
       if (shouldShowFor(Mode::kChangeMedHour)) {
-        printPad2To(mOled, mClockInfo.medInterval.hour(), '0');
+        printPad2To(mOled, interval.hour(), '0');
       } else {
         mOled.print("  ");
       }
       mOled.print(':');
       if (shouldShowFor(Mode::kChangeMedMinute)) {
-        printPad2To(mOled, mClockInfo.medInterval.minute(), '0');
+        printPad2To(mOled, interval.minute(), '0');
       } else {
         mOled.print("  ");
       }
@@ -346,6 +413,14 @@ class Presenter {
         uint8_t value = toOledContrastValue(mClockInfo.contrastLevel);
         mOled.setContrast(value);
       }
+
+      // Flash the whole display while reminding.
+      bool isInverted = mClockInfo.isReminding && mClockInfo.blinkShowState;
+      bool wasInverted = mPrevClockInfo.isReminding
+          && mPrevClockInfo.blinkShowState;
+      if (mPrevClockInfo.mode == Mode::kUnknown || isInverted != wasInverted) {
+        mOled.invertDisplay(isInverted);
+      }
     }
 
     /** Convert [0, 9] contrast level for OLED to a [0, 255] value. */
@@ -363,7 +438,11 @@ class Presenter {
   #elif TIME_ZONE_TYPE == TIME_ZONE_TYPE_EXTENDED
     ExtendedZoneManager& mZoneManager;
   #endif
+  #if ENABLE_OLED_SHADOW
+    SSD1306AsciiShadow& mOled;
+  #else
     SSD1306Ascii& mOled;
+  #endif
     ClockInfo mClockInfo;
     ClockInfo mPrevClockInfo;
 };
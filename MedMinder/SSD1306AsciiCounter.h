@@ -0,0 +1,130 @@
+#ifndef MED_MINDER_SSD1306_ASCII_COUNTER_H
+#define MED_MINDER_SSD1306_ASCII_COUNTER_H
+
+#include <SSD1306Ascii.h>
+
+/**
+ * A pass-through SSD1306Ascii which forwards every command and RAM byte to
+ * the real display, and counts the traffic sent over its bus: the number of
+ * bytes, the number of bus transactions, and the number of cursor moves. It
+ * can be placed in front of the real display, either directly under the
+ * Presenter, or under the SSD1306AsciiShadow.
+ *
+ * The bytes are forwarded to the writeDisplay() of the real display, below
+ * its own ssd1306WriteRam(), which would clip them against its own column.
+ * That column is never moved by the cursor commands of this counter, so it
+ * would stop the real display after one row of bytes.
+ *
+ * Each command byte is sent in its own transaction, and consecutive RAM bytes
+ * written with ssd1306WriteRamBuf() are sent in one transaction which is
+ * closed by ssd1306WriteRam(). A cursor move is counted for each "set page
+ * start address" command, which setCursor() sends after the 2 column
+ * commands. The I2C address and the control byte of each transaction are not
+ * included in the byte count.
+ */
+class SSD1306AsciiCounter : public SSD1306Ascii {
+  public:
+    /** Bus traffic counters. */
+    struct Traffic {
+      uint32_t bytes;
+      uint32_t transactions;
+      uint32_t cursorMoves;
+    };
+
+    /** Constructor. The real display must be initialized with its begin(). */
+    explicit SSD1306AsciiCounter(SSD1306Ascii& display) :
+        mDisplay(display) {
+      resetTraffic();
+    }
+
+    /**
+     * Initialize the counter for the given device. The initialization
+     * commands, and the clear() which follows them, are neither forwarded nor
+     * counted because the real display has already been initialized by its
+     * own begin().
+     */
+    void begin(const DevType* dev) {
+      mForwarding = false;
+      init(dev);
+      mForwarding = true;
+    }
+
+    /** The traffic since the last resetTraffic(). */
+    const Traffic& traffic() const { return mTraffic; }
+
+    void resetTraffic() {
+      mTraffic.bytes = 0;
+      mTraffic.transactions = 0;
+      mTraffic.cursorMoves = 0;
+    }
+
+  protected:
+    void writeDisplay(uint8_t b, uint8_t mode) override {
+      if (! mForwarding) return;
+      RawAccess::forward(mDisplay, b, mode);
+      if (mode == SSD1306_MODE_CMD) {
+        mTraffic.transactions++;
+        if (mPendingArgs > 0) {
+          mPendingArgs--;
+        } else {
+          mPendingArgs = numCommandArgs(b);
+          if ((b & 0xF8) == 0xB0) mTraffic.cursorMoves++;
+        }
+      } else if (mode == SSD1306_MODE_RAM) {
+        mTraffic.transactions++;
+      }
+      mTraffic.bytes++;
+    }
+
+  private:
+    /**
+     * Calls the protected writeDisplay() of another SSD1306Ascii. A derived
+     * class may take the address of a protected member through its own
+     * name, and the call through that pointer is still virtual.
+     */
+    struct RawAccess : SSD1306Ascii {
+      static void forward(SSD1306Ascii& display, uint8_t b,
+          uint8_t mode) {
+        (display.*(&RawAccess::writeDisplay))(b, mode);
+      }
+    };
+
+    /**
+     * Number of argument bytes following the given SSD1306 command, so that
+     * an argument is not mistaken for a "set page" command.
+     */
+    static uint8_t numCommandArgs(uint8_t c) {
+      switch (c) {
+        case 0x20: // memory addressing mode
+        case 0x81: // contrast
+        case 0x8D: // charge pump
+        case 0xA8: // multiplex ratio
+        case 0xAD: // DC-DC control (SH1106)
+        case 0xD3: // display offset
+        case 0xD5: // clock divide ratio
+        case 0xD9: // pre-charge period
+        case 0xDA: // COM pins configuration
+        case 0xDB: // VCOMH deselect level
+          return 1;
+        case 0x21: // column address
+        case 0x22: // page address
+        case 0xA3: // vertical scroll area
+          return 2;
+        case 0x29: // vertical and horizontal scroll
+        case 0x2A:
+          return 5;
+        case 0x26: // horizontal scroll
+        case 0x27:
+          return 6;
+        default:
+          return 0;
+      }
+    }
+
+    SSD1306Ascii& mDisplay;
+    Traffic mTraffic;
+    uint8_t mPendingArgs = 0;
+    bool mForwarding = true;
+};
+
+#endif
@@ -3,17 +3,24 @@
 
 #include <stdint.h> // uint32_t
 #include <AceTime.h>
+#include "config.h" // NUM_MEDS
+
+/** The schedule of one med, in 6 bytes. */
+struct StoredMed {
+  /** Time when the last pill was taken. */
+  uint32_t startTime;
+
+  /** How often the pill should be taken, in minutes. 0 if unused. */
+  uint16_t intervalMinutes;
+};
 
 /** Data that is saved to and retrieved from EEPROM. */
 struct StoredInfo {
   /** Current time zone. */
   ace_time::TimeZoneData timeZoneData;
 
-  /** Time when the last pill was taken. */
-  uint32_t medStartTime;
-
-  /** How often the pill should be taken. */
-  ace_time::TimePeriod medInterval;
+  /** Schedules of the meds. */
+  StoredMed meds[NUM_MEDS];
 
   /**
    * Contrast level for OLED dislay, [0, 9] -> [0, 255]. Essentially brightness
@@ -14,9 +14,78 @@
 #define ENABLE_SERIAL_DEBUG 0
 #endif
 
+// Set to 1 to benchmark the Controller and Presenter in each Mode at the end
+// of setup(), printing CSV lines to SERIAL_PORT_MONITOR. On EpoxyDuino, run
+// `make benchmark`, which exits after the benchmark.
+#ifndef ENABLE_BENCHMARK
+#define ENABLE_BENCHMARK 0
+#endif
+
+// Set to 1 to render the OLED through the 1 kB SSD1306AsciiShadow page buffer,
+// which sends only the changed column spans to the display. Too much RAM for
+// most AVR boards.
+#ifndef ENABLE_OLED_SHADOW
+  #if defined(ARDUINO_ARCH_AVR)
+    #define ENABLE_OLED_SHADOW 0
+  #else
+    #define ENABLE_OLED_SHADOW 1
+  #endif
+#endif
+
+// Set to 1 to simulate 30 days of the sleep and reminder cycle at the end of
+// setup(), and print the estimate of the EnergyMeter. On EpoxyDuino, run
+// `make simulate`, which exits after the simulation.
+#ifndef ENABLE_POWER_SIMULATION
+#define ENABLE_POWER_SIMULATION 0
+#endif
+
+// Set to 1 to accumulate the time spent in each RunMode, and the I2C, OLED
+// and EEPROM traffic, in the EnergyMeter. Needed by the power simulation.
+#ifndef ENABLE_ENERGY_METER
+#define ENABLE_ENERGY_METER ENABLE_POWER_SIMULATION
+#endif
+
+// Set to 1 to count the bytes, bus transactions and cursor moves sent to the
+// OLED, by placing an SSD1306AsciiCounter in front of it. Needed by the
+// EnergyMeter.
+#ifndef ENABLE_DISPLAY_COUNTER
+#define ENABLE_DISPLAY_COUNTER ENABLE_ENERGY_METER
+#endif
+
+// Steady-state display traffic budget, in bytes per second, of each view
+// Mode. The traffic is measured only if ENABLE_DISPLAY_COUNTER is set.
+// These values are provisional estimates, not yet recorded from a run, so
+// `make benchmark` only prints a warning when the traffic exceeds them, and
+// does not fail. Record the budget from the "Max view Mode busBytesPerSecond"
+// line of the benchmark plus a margin, before making it fail the benchmark.
+#ifndef DISPLAY_BYTES_PER_SECOND_BUDGET
+#define DISPLAY_BYTES_PER_SECOND_BUDGET 512
+#endif
+
 // PersistentStore
 #define ENABLE_EEPROM 1
 
+// Number of doses kept in the DoseLog, 3 bytes each, in the EEPROM after the
+// StoredInfo slots.
+#ifndef DOSE_LOG_CAPACITY
+#define DOSE_LOG_CAPACITY 200
+#endif
+
+// Number of StoredInfo slots in the EEPROM, written in rotation so that each
+// save wears a different slot, and a torn save leaves the previous slot intact.
+// At least 2. The flash-emulated EEPROM of the ESP8266, ESP32 and STM32
+// rewrites its whole buffer on each commit, so more slots do not reduce wear.
+// All the slots also live in that one flash sector, which is erased and
+// rewritten by the commit, so a power loss during a commit can lose every
+// slot. The torn save guarantee holds only on the AVR (and EpoxyDuino).
+#ifndef NUM_STORED_INFO_SLOTS
+  #if defined(ARDUINO_ARCH_AVR) || defined(EPOXY_DUINO)
+    #define NUM_STORED_INFO_SLOTS 8
+  #else
+    #define NUM_STORED_INFO_SLOTS 2
+  #endif
+#endif
+
 // OLED address: 0X3C+SA0 - 0x3C or 0x3D
 #define OLED_I2C_ADDRESS 0x3C
 
@@ -37,9 +106,40 @@
 // Maximum Medication interval in hours
 #define MAX_MED_INTERVAL_HOURS 36
 
+// Number of independent med schedules, 6 bytes each in the StoredInfo. With 4,
+// the StoredInfo slots and the DoseLog still fit in the 1 kB EEPROM of the
+// ATmega328.
+#ifndef NUM_MEDS
+#define NUM_MEDS 4
+#endif
+
 // Initial contrast of OLED display.
 #define OLED_INITIAL_CONTRAST 0
 
+// Minutes between the reminders after the med is due, until it is taken.
+#ifndef REMINDER_REPEAT_MINUTES
+#define REMINDER_REPEAT_MINUTES 30
+#endif
+
+// Milliseconds to flash the reminder after waking up by the alarm of the
+// DS3231, before going back to sleep.
+#ifndef REMINDER_FLASH_MILLIS
+#define REMINDER_FLASH_MILLIS 3000
+#endif
+
+// Currents used by the EnergyMeter, measured on a Pro Mini 3.3V 8MHz w/o power
+// LED. The charge of each I2C transaction, OLED byte and EEPROM byte written
+// is in nanocoulombs (uA*ms), on top of the current of the RunMode.
+#define ENERGY_AWAKE_MICROAMPS 8000 // processor and OLED on
+#define ENERGY_DREAMING_MICROAMPS 4000 // processor on, OLED off
+#define ENERGY_SLEEPING_MICROAMPS 162 // powered down, incl. the DS3231
+#define ENERGY_I2C_TRANSACTION_NANOCOULOMBS 20
+#define ENERGY_OLED_BYTE_NANOCOULOMBS 16
+#define ENERGY_EEPROM_BYTE_NANOCOULOMBS 10000 // 3.3 ms at 3 mA
+
+// Capacity of the 3 x AAA NiMH batteries.
+#define BATTERY_MILLIAMP_HOURS 800
+
 //------------------------------------------------------------------
 // Configuration of target environment. The environment is defined in
 // $HOME/.auniter.ini and the AUNITER_XXX macro is set by auniter.sh.
@@ -51,6 +151,7 @@
   #define WIFI_PASSWORD "your wifi password here"
 
   #define ENABLE_LOW_POWER 0
+  #define ENABLE_ALARM_WAKE 0
   #define TIME_PROVIDER TIME_PROVIDER_DS3231
   #define OLED_REMAP false
   #define MODE_BUTTON_PIN 8
@@ -62,6 +163,7 @@
   #define WIFI_PASSWORD "your wifi password here"
 
   #define ENABLE_LOW_POWER 0
+  #define ENABLE_ALARM_WAKE 0
   #define TIME_PROVIDER TIME_PROVIDER_DS3231
   #define OLED_REMAP false
   #define MODE_BUTTON_PIN 8
@@ -75,6 +177,7 @@
   #undef TIME_ZONE_TYPE
   #define TIME_ZONE_TYPE TIME_ZONE_TYPE_BASIC
   #define ENABLE_LOW_POWER 0
+  #define ENABLE_ALARM_WAKE 0
   #define TIME_PROVIDER TIME_PROVIDER_DS3231
   #define OLED_REMAP true
   #define MODE_BUTTON_PIN A2
@@ -85,6 +188,8 @@
   //#define WIFI_PASSWORD
 
   #define ENABLE_LOW_POWER 1
+  #define ENABLE_ALARM_WAKE 1
+  #define ALARM_INTERRUPT_PIN 4 // INT/SQW of the DS3231
   #define TIME_PROVIDER TIME_PROVIDER_DS3231
   #define OLED_REMAP false
   #define MODE_BUTTON_PIN 2
@@ -95,6 +200,7 @@
   //#define WIFI_PASSWORD
 
   #define ENABLE_LOW_POWER 0
+  #define ENABLE_ALARM_WAKE 0
   #define TIME_PROVIDER TIME_PROVIDER_DS3231
   #define OLED_REMAP false
   #define MODE_BUTTON_PIN D4
@@ -105,6 +211,7 @@
   //#define WIFI_PASSWORD
 
   #define ENABLE_LOW_POWER 0
+  #define ENABLE_ALARM_WAKE 0
   #define TIME_PROVIDER TIME_PROVIDER_NTP
   #define OLED_REMAP false
   #define MODE_BUTTON_PIN 15
@@ -117,11 +224,20 @@
 // Constants for button and UI states.
 //------------------------------------------------------------------
 
+/** Power state of the processor, managed by the manageSleep coroutine. */
+enum class RunMode : uint8_t {
+  kAwake,
+  kSleeping,
+  kDreaming,
+  kReminding,
+};
+
 enum class Mode : uint8_t {
   kUnknown = 0, // uninitialized
 
   // View modes
   kViewMed,
+  kViewDoses,
   kViewDateTime,
   kViewTimeZone,
   kViewSettings,
@@ -9,7 +9,9 @@
 #include "ClockInfo.h"
 #include "StoredInfo.h"
 #include "PersistentStore.h"
+#include "PhaseEstimator.h"
 #include "Presenter.h"
+#include "ZoneWindow.h"
 
 using namespace ace_time;
 using namespace ace_time::clock;
@@ -31,13 +33,14 @@ class Controller {
     // Number of minutes to use for a DST offset.
     static const int16_t kDstOffsetMinutes = 60;
 
+
     /**
      * Constructor.
      * @param persistentStore stores objects into the EEPROM with CRC
      * @param clock source of the current time
      * @param presenter renders the date and time info to the screen
-     * @param zoneManager optional zoneManager for TIME_ZONE_TYPE_BASIC or
-     *        TIME_ZONE_TYPE_EXTENDED
+     * @param zoneManager ManualZoneManager for TIME_ZONE_TYPE_MANUAL, or the
+     *        ZoneCache for TIME_ZONE_TYPE_BASIC or TIME_ZONE_TYPE_EXTENDED
      * @param displayZones array of TimeZoneData with NUM_TIME_ZONES elements
      */
     Controller(
@@ -47,9 +50,9 @@ class Controller {
       #if TIME_ZONE_TYPE == TIME_ZONE_TYPE_MANUAL
         ManualZoneManager& zoneManager,
       #elif TIME_ZONE_TYPE == TIME_ZONE_TYPE_BASIC
-        BasicZoneManager& zoneManager,
+        BasicZoneCache& zoneManager,
       #elif TIME_ZONE_TYPE == TIME_ZONE_TYPE_EXTENDED
-        ExtendedZoneManager& zoneManager,
+        ExtendedZoneCache& zoneManager,
       #endif
         TimeZoneData const* displayZones
     ) :
@@ -80,16 +83,60 @@ class Controller {
     }
 
     /**
-     * This should be called every 0.1s to support blinking mode and to avoid
-     * noticeable drift against the RTC which has a 1 second resolution.
+     * Return true if update() should be called. The ClockInfo can change only
+     * when the SystemClock rolls over to the next second, when the blinking
+     * state toggles in a Change mode, or when a button is pressed. Between
+     * those events, this returns false using only millis(), so it can be
+     * polled on every iteration of loop().
+     *
+     * The PhaseEstimator predicts the rollover, and the SystemClock is
+     * polled only from slightly ahead of it until its seconds change.
      */
-    void update() {
-      if (mClockInfo.mode == Mode::kUnknown) return;
+    bool isUpdateDue() {
+      if (mUpdateRequested) return true;
+
+      uint16_t nowMillis = millis();
+      if ((uint16_t) (nowMillis - mLastUpdateMillis)
+          >= PhaseEstimator::kSecondMillis) {
+        return true;
+      }
+      if (mPhaseEstimator.isBeforeWindow(nowMillis)) return false;
+
+      if (mClock.getNow() != mPrevSeconds) return true;
+      mPhaseEstimator.observeOldSecond(nowMillis);
+      return false;
+    }
+
+    /** Return the current Mode, used by the benchmark. */
+    Mode getMode() const { return mClockInfo.mode; }
+
+    /**
+     * Update the ClockInfo from the clock and pass it to the Presenter,
+     * without rendering the display.
+     */
+    void updateClockInfo() {
       updateDateTime();
       updatePresenter();
+    }
+
+    /**
+     * Update the ClockInfo and render it. This should be called whenever
+     * isUpdateDue() returns true. It can be called more often (e.g. every
+     * 0.1s), but the output changes only at the events tracked by
+     * isUpdateDue().
+     */
+    void update() {
+      if (mClockInfo.mode == Mode::kUnknown) return;
+      mUpdateRequested = false;
+      mLastUpdateMillis = millis();
+      updateClockInfo();
       mPresenter.updateDisplay();
+      mPhaseEstimator.recordRender(millis());
     }
 
+    /** Estimator of the rollover of the SystemClock, with its statistics. */
+    PhaseEstimator& getPhaseEstimator() { return mPhaseEstimator; }
+
     /**
      * The blinking clock is different than the SystemClock, so the blinking
      * will becomes slightly skewed from the changes to the 'second' field. If
@@ -103,6 +150,9 @@ class Controller {
       mClockInfo.blinkShowState = !mClockInfo.blinkShowState;
       mChangingClockInfo.blinkShowState = !mChangingClockInfo.blinkShowState;
       updatePresenter();
+
+      // The blinking state is rendered only in the Change modes.
+      if (isChangeMode(mClockInfo.mode)) mUpdateRequested = true;
     }
 
     void handleModeButtonPress() {
@@ -228,6 +278,7 @@ class Controller {
       }
 
       mChangingClockInfo.mode = mClockInfo.mode;
+      mUpdateRequested = true;
     }
 
     /** Perform the action of the current ModeRecord. */
@@ -367,6 +418,7 @@ class Controller {
       }
 
       mChangingClockInfo.mode = mClockInfo.mode;
+      mUpdateRequested = true;
     }
 
     /**
@@ -420,6 +472,8 @@ class Controller {
         default:
           break;
       }
+
+      mUpdateRequested = true;
     }
 
     // If the system clock hasn't been initialized, set the initial
@@ -607,6 +661,7 @@ class Controller {
       #endif
           mClockInfo.suppressBlink = false;
           mChangingClockInfo.suppressBlink = false;
+          mUpdateRequested = true;
           break;
 
         default:
@@ -622,8 +677,14 @@ class Controller {
     void updateDateTime() {
       // Update the current dateTime from the SystemClock epochSeconds, using
       // the timezone at zones[0].
-      TimeZone tz = mZoneManager.createForTimeZoneData(mClockInfo.zones[0]);
-      mClockInfo.dateTime = ZonedDateTime::forEpochSeconds(mClock.getNow(), tz);
+      acetime_t nowSeconds = mClock.getNow();
+      trackRollover(nowSeconds);
+      const TimeZoneData& zoneData = mClockInfo.zones[0];
+      if (! mZoneWindow.isValid(nowSeconds, zoneData)) {
+        TimeZone tz = mZoneManager.createForTimeZoneData(zoneData);
+        mZoneWindow.reset(nowSeconds, zoneData, tz);
+      }
+      mClockInfo.dateTime = mZoneWindow.forEpochSeconds(nowSeconds);
 
       //acetime_t lastSync = mClock.getLastSyncTime();
       int32_t secondsSinceSyncAttempt = mClock.getSecondsSinceSyncAttempt();
@@ -660,10 +721,20 @@ class Controller {
       }
     }
 
-    void updatePresenter() {
-      ClockInfo* clockInfo;
+    /** Feed the millis() of a new second of the clock to the PhaseEstimator. */
+    void trackRollover(acetime_t nowSeconds) {
+      if (nowSeconds == mPrevSeconds) return;
 
-      switch (mClockInfo.mode) {
+      mPrevSeconds = nowSeconds;
+      mPhaseEstimator.observeRollover(mLastUpdateMillis);
+    }
+
+    /**
+     * Return true if the mode edits the mChangingClockInfo, which is then
+     * rendered instead of the current mClockInfo.
+     */
+    static bool isChangeMode(Mode mode) {
+      switch (mode) {
         // If we are changing the current date, time or time zones, render the
         // mChangingClockInfo instead, because changes are made to the copy,
         // instead of the current mClockInfo, and copied over to mClockInfo
@@ -697,17 +768,20 @@ class Controller {
         case Mode::kChangeSettingsContrast:
         case Mode::kChangeInvertDisplay:
       #endif
-          clockInfo = &mChangingClockInfo;
-          break;
+          return true;
 
-        // For all other modes render the normal mClockInfo instead. This
-        // includes the "change settings" modes, because those are applied
-        // directly to the current mClockInfo, not the mChangingClockInfo.
+        // For all other modes render the normal mClockInfo instead.
         default:
-          clockInfo = &mClockInfo;
+          return false;
       }
+    }
 
-      mPresenter.setClockInfo(*clockInfo);
+    void updatePresenter() {
+      if (isChangeMode(mClockInfo.mode)) {
+        mPresenter.setClockInfo(mChangingClockInfo);
+      } else {
+        mPresenter.setClockInfo(mClockInfo);
+      }
     }
 
     /** Save the changed dateTime to the SystemClock. */
@@ -732,7 +806,17 @@ class Controller {
       }
       StoredInfo storedInfo;
       storedInfoFromClockInfo(storedInfo, clockInfo);
-      mPersistentStore.writeStoredInfo(storedInfo);
+      mPersistentStore.saveStoredInfo(storedInfo);
+      pinDisplayedZones(clockInfo);
+    }
+
+    /** Keep the zone processors of the displayed zones in the cache. */
+    void pinDisplayedZones(const ClockInfo& clockInfo) {
+    #if TIME_ZONE_TYPE != TIME_ZONE_TYPE_MANUAL
+      mZoneManager.pin(clockInfo.zones);
+    #else
+      (void) clockInfo;
+    #endif
     }
 
     /** Convert StoredInfo to ClockInfo. */
@@ -789,6 +873,7 @@ class Controller {
 
       if (isValid) {
         clockInfoFromStoredInfo(mClockInfo, storedInfo);
+        pinDisplayedZones(mClockInfo);
       } else {
         setupClockInfo();
         preserveClockInfo(mClockInfo);
@@ -819,13 +904,16 @@ class Controller {
   #if TIME_ZONE_TYPE == TIME_ZONE_TYPE_MANUAL
     ManualZoneManager& mZoneManager;
   #elif TIME_ZONE_TYPE == TIME_ZONE_TYPE_BASIC
-    BasicZoneManager& mZoneManager;
+    BasicZoneCache& mZoneManager;
   #elif TIME_ZONE_TYPE == TIME_ZONE_TYPE_EXTENDED
-    ExtendedZoneManager& mZoneManager;
+    ExtendedZoneCache& mZoneManager;
   #endif
 
     TimeZoneData const* const mDisplayZones;
 
+    // UTC offset of zones[0], valid until its next DST transition.
+    ZoneWindow mZoneWindow;
+
     ClockInfo mClockInfo; // current clock
     ClockInfo mChangingClockInfo; // the target clock
 
@@ -839,6 +927,12 @@ class Controller {
     uint16_t mZoneRegistryIndex = 0;
 
     bool mSecondFieldCleared = false;
+
+    // State of the update scheduling in isUpdateDue().
+    PhaseEstimator mPhaseEstimator;
+    acetime_t mPrevSeconds = 0;
+    uint16_t mLastUpdateMillis = 0;
+    bool mUpdateRequested = true;
 };
 
 #endif
@@ -41,6 +41,12 @@
 #endif
 #include "PersistentStore.h"
 #include "Controller.h"
+#include "Benchmark.h"
+#include "EdgeButtonConfig.h"
+#include "SyncPolicy.h"
+#if DISPLAY_TYPE == DISPLAY_TYPE_OLED
+  #include "SSD1306AsciiCounter.h"
+#endif
 
 using namespace ace_button;
 using namespace ace_routine;
@@ -110,11 +116,15 @@ static const basic::Info::ZoneInfo* const ZONE_REGISTRY[] ACE_TIME_PROGMEM = {
 static const uint16_t ZONE_REGISTRY_SIZE =
     sizeof(ZONE_REGISTRY) / sizeof(basic::Info::ZoneInfo*);
 
-// Only 4 are displayed at any given time, need 5 for conversions.
-static const uint16_t CACHE_SIZE = NUM_TIME_ZONES + 1;
-static BasicZoneProcessorCache<CACHE_SIZE> zoneProcessorCache;
-static BasicZoneManager zoneManager(
-    ZONE_REGISTRY_SIZE, ZONE_REGISTRY, zoneProcessorCache);
+// The NUM_TIME_ZONES displayed zones are pinned in their own cache, and the
+// zones scrolled through in the Change modes use a separate 1-slot cache.
+static BasicZoneProcessorCache<NUM_TIME_ZONES> pinnedProcessorCache;
+static BasicZoneProcessorCache<1> scratchProcessorCache;
+static BasicZoneManager pinnedZoneManager(
+    ZONE_REGISTRY_SIZE, ZONE_REGISTRY, pinnedProcessorCache);
+static BasicZoneManager scratchZoneManager(
+    ZONE_REGISTRY_SIZE, ZONE_REGISTRY, scratchProcessorCache);
+static BasicZoneCache zoneManager(pinnedZoneManager, scratchZoneManager);
 
 #elif TIME_ZONE_TYPE == TIME_ZONE_TYPE_EXTENDED
 
@@ -132,11 +142,15 @@ static const extended::Info::ZoneInfo* const ZONE_REGISTRY[]
 static const uint16_t ZONE_REGISTRY_SIZE =
     sizeof(ZONE_REGISTRY) / sizeof(extended::Info::ZoneInfo*);
 
-// Cache size should be one more than the number of time zones displayed.
-static const uint16_t CACHE_SIZE = NUM_TIME_ZONES + 1;
-static ExtendedZoneProcessorCache<CACHE_SIZE> zoneProcessorCache;
-static ExtendedZoneManager zoneManager(
-    ZONE_REGISTRY_SIZE, ZONE_REGISTRY, zoneProcessorCache);
+// The NUM_TIME_ZONES displayed zones are pinned in their own cache, and the
+// zones scrolled through in the Change modes use a separate 1-slot cache.
+static ExtendedZoneProcessorCache<NUM_TIME_ZONES> pinnedProcessorCache;
+static ExtendedZoneProcessorCache<1> scratchProcessorCache;
+static ExtendedZoneManager pinnedZoneManager(
+    ZONE_REGISTRY_SIZE, ZONE_REGISTRY, pinnedProcessorCache);
+static ExtendedZoneManager scratchZoneManager(
+    ZONE_REGISTRY_SIZE, ZONE_REGISTRY, scratchProcessorCache);
+static ExtendedZoneCache zoneManager(pinnedZoneManager, scratchZoneManager);
 
 #elif TIME_ZONE_TYPE == TIME_ZONE_TYPE_BASICDB
 
@@ -247,7 +261,29 @@ void setupZoneManager() {
   #error Unknown BACKUP_TIME_SOURCE_TYPE
 #endif
 
-SYSTEM_CLOCK systemClock(refClock, backupClock, 60 /*syncPeriod*/);
+// The SyncPolicy forces each sync with a blocking read of the reference clock,
+// which would stall loop() for up to the request timeout of the NtpClock. So
+// an NTP build keeps the fixed SYNC_PERIOD_MIN_SECONDS of the systemClock,
+// whose coroutine syncs without blocking. Without a reference clock, there is
+// nothing to sync with.
+#if TIME_SOURCE_TYPE == TIME_SOURCE_TYPE_NONE \
+    || TIME_SOURCE_TYPE == TIME_SOURCE_TYPE_NTP
+  #define ENABLE_SYNC_POLICY 0
+  #define SYSTEM_CLOCK_SYNC_SECONDS SYNC_PERIOD_MIN_SECONDS
+#else
+  #define ENABLE_SYNC_POLICY 1
+  #define SYSTEM_CLOCK_SYNC_SECONDS SYNC_PERIOD_MAX_SECONDS
+#endif
+
+SYSTEM_CLOCK systemClock(
+    refClock, backupClock, SYSTEM_CLOCK_SYNC_SECONDS /*syncPeriod*/);
+
+#if ENABLE_SYNC_POLICY
+// Syncs the systemClock as often as its measured drift requires, between
+// SYNC_PERIOD_MIN_SECONDS and the SYNC_PERIOD_MAX_SECONDS of the systemClock.
+SyncPolicy syncPolicy(systemClock, SYNC_PERIOD_MIN_SECONDS,
+    SYNC_PERIOD_MAX_SECONDS, SYNC_SKEW_BOUND_SECONDS);
+#endif
 
 void setupClocks() {
 #if TIME_SOURCE_TYPE == TIME_SOURCE_TYPE_DS3231 \
@@ -272,6 +308,15 @@ void setupClocks() {
 
 #if DISPLAY_TYPE == DISPLAY_TYPE_OLED
   SSD1306AsciiAceWire<WireInterface> oled(wireInterface);
+  #if ENABLE_DISPLAY_COUNTER
+    SSD1306AsciiCounter oledCounter(oled);
+    SSD1306Ascii& oledBus = oledCounter;
+  #else
+    SSD1306Ascii& oledBus = oled;
+  #endif
+  #if ENABLE_OLED_SHADOW
+    SSD1306AsciiShadow oledShadow(oledBus);
+  #endif
 
   void setupDisplay() {
     oled.begin(&Adafruit128x64, OLED_I2C_ADDRESS);
@@ -279,9 +324,21 @@ void setupClocks() {
     oled.setScrollMode(false);
     oled.clear();
     oled.setContrast(OLED_INITIAL_CONTRAST);
+  #if ENABLE_DISPLAY_COUNTER
+    oledCounter.begin(&Adafruit128x64);
+    oledCounter.setScrollMode(false);
+  #endif
+  #if ENABLE_OLED_SHADOW
+    oledShadow.begin(&Adafruit128x64);
+    oledShadow.setScrollMode(false);
+  #endif
   }
 #else
-  Adafruit_PCD8544 lcd = Adafruit_PCD8544(LCD_SPI_DATA_COMMAND_PIN, -1, -1);
+  #if ENABLE_LCD_SHADOW
+    PCD8544Shadow lcd(LCD_SPI_DATA_COMMAND_PIN, -1, -1);
+  #else
+    Adafruit_PCD8544 lcd = Adafruit_PCD8544(LCD_SPI_DATA_COMMAND_PIN, -1, -1);
+  #endif
 
   void setupDisplay() {
     lcd.begin();
@@ -290,8 +347,12 @@ void setupClocks() {
     lcd.setBias(LCD_INITIAL_BIAS);
 
     lcd.setTextWrap(false);
+  #if ENABLE_LCD_SHADOW
+    lcd.resetDisplay();
+  #else
     lcd.clearDisplay();
     lcd.display();
+  #endif
   }
 #endif
 
@@ -299,10 +360,13 @@ void setupClocks() {
 // Create presenter
 //-----------------------------------------------------------------------------
 
-#if DISPLAY_TYPE == DISPLAY_TYPE_OLED
-  Presenter presenter(zoneManager, oled, true /*isOverwriting*/);
+#if DISPLAY_TYPE == DISPLAY_TYPE_OLED && ENABLE_OLED_SHADOW
+  Presenter presenter(zoneManager, oledShadow, true /*isOverwriting*/);
+#elif DISPLAY_TYPE == DISPLAY_TYPE_OLED
+  Presenter presenter(zoneManager, oledBus, true /*isOverwriting*/);
 #else
-  Presenter presenter(zoneManager, lcd, false /*isOverwriting*/);
+  // With the PCD8544Shadow, the text is drawn with an opaque background.
+  Presenter presenter(zoneManager, lcd, ENABLE_LCD_SHADOW /*isOverwriting*/);
 #endif
 
 void setupPresenter() {
@@ -312,7 +376,8 @@ void setupPresenter() {
 // Create persistent store.
 //-----------------------------------------------------------------------------
 
-const uint32_t kContextId = 0x03c4711f; // random contextId
+// Random contextId, changed whenever the layout of the StoredInfo changes.
+const uint32_t kContextId = 0x341ef6bc;
 const uint16_t kStoredInfoEepromAddress = 0;
 
 PersistentStore persistentStore(kContextId, kStoredInfoEepromAddress);
@@ -344,8 +409,9 @@ class RateMonitor {
       startMillis = millis();
     }
 
-    void sample() {
+    void sample(uint16_t bytes) {
       frameCounter++;
+      byteCounter += bytes;
     }
 
     void printFrameRate() {
@@ -356,33 +422,42 @@ class RateMonitor {
       Serial.print(frameCounter);
       float fps = frameCounter * 1000.0f / elapsedMillis;
       Serial.print("; fps: ");
-      Serial.println(fps);
+      Serial.print(fps);
+      Serial.print("; display bytes: ");
+      Serial.print(byteCounter);
+      float bps = byteCounter * 1000.0f / elapsedMillis;
+      Serial.print("; bytes/s: ");
+      Serial.println(bps);
     }
 
     void reset() {
       startMillis = millis();
       frameCounter = 0;
+      byteCounter = 0;
     }
 
   private:
     unsigned long startMillis;
     int frameCounter = 0;
+    uint32_t byteCounter = 0;
 };
 
 RateMonitor frameMonitor;
 #endif
 
-// The RTC has a resolution of only 1s, so we need to poll it fast enough to
-// make it appear that the display is tracking it correctly. The benchmarking
-// code says that controller.display() runs as fast as or faster than 1ms, so
-// we can set this to 100ms without worrying about too much overhead.
+// The RTC has a resolution of only 1s, so the display can change only when the
+// SystemClock rolls over to the next second, when the blinking state toggles,
+// or when a button is pressed. Instead of polling controller.update() every
+// 100ms, wait until controller.isUpdateDue() says that one of those has
+// happened. This calls update() about once a second, aligned with the
+// rollover of the SystemClock.
 COROUTINE(displayClock) {
   COROUTINE_LOOP() {
+    COROUTINE_AWAIT(controller.isUpdateDue());
     controller.update();
     #if ENABLE_FPS_DEBUG
-      frameMonitor.sample();
+      frameMonitor.sample(presenter.getFrameBytes());
     #endif
-    COROUTINE_DELAY(100);
   }
 }
 
@@ -390,8 +465,10 @@ COROUTINE(displayClock) {
 COROUTINE(printFrameRate) {
   COROUTINE_LOOP() {
     frameMonitor.reset();
+    controller.getPhaseEstimator().resetStats();
     COROUTINE_DELAY(5000);
     frameMonitor.printFrameRate();
+    controller.getPhaseEstimator().printStatsTo(Serial);
   }
 }
 #endif
@@ -407,7 +484,34 @@ COROUTINE(blinker) {
 // Configure AceButton.
 //-----------------------------------------------------------------------------
 
-#if BUTTON_TYPE == BUTTON_TYPE_DIGITAL
+#if ENABLE_BUTTON_INTERRUPTS && BUTTON_TYPE != BUTTON_TYPE_DIGITAL
+  #error ENABLE_BUTTON_INTERRUPTS requires BUTTON_TYPE_DIGITAL
+#endif
+
+// Millis between checks of the buttons. With ENABLE_BUTTON_INTERRUPTS, only
+// while a press is in progress.
+static const uint8_t BUTTON_CHECK_MILLIS = 6;
+
+#if BUTTON_TYPE == BUTTON_TYPE_DIGITAL && ENABLE_BUTTON_INTERRUPTS
+
+  static const uint8_t MODE_BUTTON_INDEX = 0;
+  static const uint8_t CHANGE_BUTTON_INDEX = 1;
+
+  EdgeButtonConfig<2, 16> buttonConfig;
+  AceButton modeButton(&buttonConfig, MODE_BUTTON_PIN);
+  AceButton changeButton(&buttonConfig, CHANGE_BUTTON_PIN);
+
+  EDGE_BUTTON_ISR_ATTR void modeButtonInterrupt() {
+    buttonConfig.pushEdge(
+        MODE_BUTTON_INDEX, digitalRead(MODE_BUTTON_PIN), millis());
+  }
+
+  EDGE_BUTTON_ISR_ATTR void changeButtonInterrupt() {
+    buttonConfig.pushEdge(
+        CHANGE_BUTTON_INDEX, digitalRead(CHANGE_BUTTON_PIN), millis());
+  }
+
+#elif BUTTON_TYPE == BUTTON_TYPE_DIGITAL
 
   ButtonConfig buttonConfig;
   AceButton modeButton(&buttonConfig, MODE_BUTTON_PIN);
@@ -490,6 +594,19 @@ void setupAceButton() {
   pinMode(CHANGE_BUTTON_PIN, INPUT_PULLUP);
 #endif
 
+#if ENABLE_BUTTON_INTERRUPTS
+  buttonConfig.attach(MODE_BUTTON_INDEX, &modeButton);
+  buttonConfig.attach(CHANGE_BUTTON_INDEX, &changeButton);
+  buttonConfig.setup();
+  // The EpoxyDuino has no interrupts. Its edges are pushed by the benchmark.
+  #if ! defined(EPOXY_DUINO)
+    attachInterrupt(digitalPinToInterrupt(MODE_BUTTON_PIN),
+        modeButtonInterrupt, CHANGE);
+    attachInterrupt(digitalPinToInterrupt(CHANGE_BUTTON_PIN),
+        changeButtonInterrupt, CHANGE);
+  #endif
+#endif
+
   buttonConfig.setEventHandler(handleButton);
   buttonConfig.setFeature(ButtonConfig::kFeatureDoubleClick);
   buttonConfig.setFeature(ButtonConfig::kFeatureSuppressAfterDoubleClick);
@@ -508,16 +625,22 @@ void setupAceButton() {
 // becomes disconnected after 5-10 seconds. See
 // https://github.com/esp8266/Arduino/issues/1634 and
 // https://github.com/esp8266/Arduino/issues/5083.
+//
+// With ENABLE_BUTTON_INTERRUPTS, wait until an interrupt queues an edge, then
+// check the buttons until the press and its click timers are done.
 COROUTINE(readButtons) {
   COROUTINE_LOOP() {
-  #if BUTTON_TYPE == BUTTON_TYPE_DIGITAL
+  #if ENABLE_BUTTON_INTERRUPTS
+    COROUTINE_AWAIT(buttonConfig.isActive(millis()));
+    buttonConfig.check(millis());
+  #elif BUTTON_TYPE == BUTTON_TYPE_DIGITAL
     modeButton.check();
     changeButton.check();
   #else
     buttonConfig.checkButtons();
   #endif
 
-    COROUTINE_DELAY(6);
+    COROUTINE_DELAY(BUTTON_CHECK_MILLIS);
   }
 }
 
@@ -585,6 +708,19 @@ void setupWire() {
   wireInterface.begin();
 }
 
+//-----------------------------------------------------------------------------
+// Print the hit rate of the zone cache of the Presenter.
+//-----------------------------------------------------------------------------
+
+#if ENABLE_SERIAL_DEBUG >= 1
+COROUTINE(printZoneCacheStats) {
+  COROUTINE_LOOP() {
+    COROUTINE_DELAY_SECONDS(10);
+    presenter.printZoneCacheStatsTo(SERIAL_PORT_MONITOR);
+  }
+}
+#endif
+
 //-----------------------------------------------------------------------------
 // Debugging ace_time::SystemClockCoroutine which does not seem to get
 // inserted into the linked list.
@@ -600,6 +736,277 @@ COROUTINE(monitor) {
 }
 #endif
 
+//-----------------------------------------------------------------------------
+// Benchmark the Controller and the Presenter in each Mode.
+//-----------------------------------------------------------------------------
+
+#if ENABLE_BENCHMARK
+
+static const uint16_t BENCHMARK_ITERATIONS = 100;
+
+// Stop if the Mode button never cycles back to the first Mode.
+static const uint8_t BENCHMARK_MAX_MODES = 64;
+
+// Start of the clock in each Mode.
+static acetime_t benchmarkStartSeconds;
+
+// Set if the steady-state display traffic exceeds its budget.
+static bool benchmarkOverBudget = false;
+
+// Highest steady-state display traffic of the view Modes, in bytes per second.
+static uint32_t benchmarkMaxViewBytesPerSecond = 0;
+
+// Print the display traffic per second after the first iteration, and check
+// it against the DISPLAY_BYTES_PER_SECOND_BUDGET.
+void printBenchmarkTraffic(uint8_t mode, uint32_t frameBytes,
+    bool checkBudget) {
+  uint16_t seconds = BENCHMARK_ITERATIONS - 1;
+#if DISPLAY_TYPE == DISPLAY_TYPE_OLED && ENABLE_DISPLAY_COUNTER
+  (void) frameBytes;
+  const SSD1306AsciiCounter::Traffic& traffic = oledCounter.traffic();
+  uint32_t bytes = traffic.bytes;
+  BenchmarkTimer::printLineTo(SERIAL_PORT_MONITOR, F("MultiZoneClock"), mode,
+      F("busTransactionsPerSecond"), seconds, traffic.transactions / seconds);
+  BenchmarkTimer::printLineTo(SERIAL_PORT_MONITOR, F("MultiZoneClock"), mode,
+      F("busCursorMovesPerSecond"), seconds, traffic.cursorMoves / seconds);
+#else
+  uint32_t bytes = frameBytes;
+#endif
+  BenchmarkTimer::printLineTo(SERIAL_PORT_MONITOR, F("MultiZoneClock"), mode,
+      F("busBytesPerSecond"), seconds, bytes / seconds);
+  // Each second renders 2 frames, after the update and after the blink.
+  BenchmarkTimer::printLineTo(SERIAL_PORT_MONITOR, F("MultiZoneClock"), mode,
+      F("busBytesPerFrame"), 2 * seconds, bytes / (2 * seconds));
+
+  if (checkBudget) {
+    uint32_t bytesPerSecond = bytes / seconds;
+    if (bytesPerSecond > benchmarkMaxViewBytesPerSecond) {
+      benchmarkMaxViewBytesPerSecond = bytesPerSecond;
+    }
+    if (bytesPerSecond > DISPLAY_BYTES_PER_SECOND_BUDGET) {
+      benchmarkOverBudget = true;
+    }
+  }
+}
+
+// Time each operation BENCHMARK_ITERATIONS times in the current Mode, with the
+// SystemClock advanced by 1 second before each iteration.
+// The update is the Controller alone, and each render is timed by
+// updateDisplay, after both the update and the blink.
+void benchmarkMode(bool isViewMode) {
+  BenchmarkTimer updateTimer;
+  BenchmarkTimer blinkTimer;
+  BenchmarkTimer displayTimer;
+  uint32_t frameBytes = 0;
+
+  for (uint16_t i = 0; i < BENCHMARK_ITERATIONS; ++i) {
+    systemClock.setNow(benchmarkStartSeconds + i);
+    updateTimer.start();
+    controller.updateClockInfo();
+    updateTimer.stop();
+    displayTimer.start();
+    presenter.updateDisplay();
+    displayTimer.stop();
+    frameBytes += presenter.getFrameBytes();
+    blinkTimer.start();
+    controller.updateBlinkState();
+    blinkTimer.stop();
+    displayTimer.start();
+    presenter.updateDisplay();
+    displayTimer.stop();
+    frameBytes += presenter.getFrameBytes();
+
+    // The first iteration redraws the whole screen of the new Mode.
+    if (i == 0) {
+      frameBytes = 0;
+    #if DISPLAY_TYPE == DISPLAY_TYPE_OLED && ENABLE_DISPLAY_COUNTER
+      oledCounter.resetTraffic();
+    #endif
+    }
+  }
+
+  uint8_t mode = (uint8_t) controller.getMode();
+  updateTimer.printTo(
+      SERIAL_PORT_MONITOR, F("MultiZoneClock"), mode, F("update"));
+  blinkTimer.printTo(
+      SERIAL_PORT_MONITOR, F("MultiZoneClock"), mode, F("updateBlinkState"));
+  displayTimer.printTo(
+      SERIAL_PORT_MONITOR, F("MultiZoneClock"), mode, F("updateDisplay"));
+  printBenchmarkTraffic(mode, frameBytes, isViewMode);
+}
+
+#if ENABLE_BUTTON_INTERRUPTS
+
+// A simulated edge of the Change button, at the given millis of the run,
+// preceded by the given number of bounces (pairs of opposite edges) in the same
+// millisecond.
+struct BenchmarkEdge {
+  uint16_t millis;
+  uint8_t state;
+  uint8_t bounces;
+};
+
+// A click of the Change button, with contact bounce on the press and the
+// release, in the middle of 3 seconds of idle time.
+static const BenchmarkEdge BENCHMARK_EDGES[] = {
+  {1000, LOW, 0}, {1002, HIGH, 0}, {1003, LOW, 0},
+  {1150, HIGH, 0}, {1151, LOW, 0}, {1152, HIGH, 0},
+};
+
+// The same click, with a longer bounce, which pushes more edges than the ring
+// of the buttonConfig holds before the next check(). The settled edges are
+// dropped.
+static const BenchmarkEdge BENCHMARK_BOUNCE_EDGES[] = {
+  {1000, LOW, 20}, {1150, HIGH, 20},
+};
+
+static const uint16_t BENCHMARK_BUTTON_MILLIS = 3000;
+
+static uint16_t benchmarkButtonMillis;
+static uint16_t benchmarkPressedMillis;
+static bool benchmarkPressed;
+static uint8_t benchmarkLongPresses;
+
+// Record when the first Pressed event arrives, and count the LongPressed and
+// RepeatPressed events, instead of acting on them.
+void handleBenchmarkButton(AceButton* /*button*/, uint8_t eventType,
+    uint8_t /*buttonState*/) {
+  if (eventType == AceButton::kEventPressed && ! benchmarkPressed) {
+    benchmarkPressed = true;
+    benchmarkPressedMillis = benchmarkButtonMillis;
+  } else if (eventType == AceButton::kEventLongPressed
+      || eventType == AceButton::kEventRepeatPressed) {
+    benchmarkLongPresses++;
+  }
+}
+
+// Replay the given edges 1 millisecond at a time, from startMillis, as the
+// readButtons coroutine would see them: either polling the pin every
+// BUTTON_CHECK_MILLIS, or woken by the interrupts.
+void replayButtonEdges(const BenchmarkEdge* edges, uint8_t numEdges,
+    bool interrupts, uint16_t startMillis) {
+  buttonConfig.setEventHandler(handleBenchmarkButton);
+  buttonConfig.resetNumChecks();
+  benchmarkPressed = false;
+  benchmarkLongPresses = 0;
+
+  uint8_t next = 0;
+  uint8_t state = HIGH;
+  uint8_t polledState = HIGH;
+  uint16_t resumeMillis = startMillis;
+  for (uint16_t t = 0; t < BENCHMARK_BUTTON_MILLIS; ++t) {
+    uint16_t nowMillis = startMillis + t;
+    benchmarkButtonMillis = nowMillis;
+    for (; next < numEdges && edges[next].millis == t; ++next) {
+      state = edges[next].state;
+      if (interrupts) {
+        for (uint8_t i = 0; i < edges[next].bounces; ++i) {
+          buttonConfig.pushEdge(CHANGE_BUTTON_INDEX, state, nowMillis);
+          buttonConfig.pushEdge(CHANGE_BUTTON_INDEX, ! state, nowMillis);
+        }
+        buttonConfig.pushEdge(CHANGE_BUTTON_INDEX, state, nowMillis);
+      }
+    }
+
+    if (interrupts) {
+      if ((int16_t) (nowMillis - resumeMillis) >= 0
+          && buttonConfig.isActive(nowMillis)) {
+        buttonConfig.check(nowMillis);
+        resumeMillis = nowMillis + BUTTON_CHECK_MILLIS;
+      }
+    } else if (t % BUTTON_CHECK_MILLIS == 0) {
+      // A poll sees only the state of the pin at the time of the poll.
+      if (state != polledState) {
+        polledState = state;
+        buttonConfig.pushEdge(CHANGE_BUTTON_INDEX, state, nowMillis);
+      }
+      buttonConfig.check(nowMillis);
+    }
+  }
+
+  buttonConfig.setEventHandler(handleButton);
+}
+
+// Replay the BENCHMARK_EDGES. Print the number of checks of the buttons (the
+// wakeups) in the whole run, and the millis from the press to its Pressed
+// event. The display is redrawn by the next displayClock, in the same loop()
+// as the event.
+void benchmarkButtons(bool interrupts, uint16_t startMillis) {
+  replayButtonEdges(BENCHMARK_EDGES,
+      sizeof(BENCHMARK_EDGES) / sizeof(BENCHMARK_EDGES[0]),
+      interrupts, startMillis);
+
+  uint8_t mode = (uint8_t) controller.getMode();
+  BenchmarkTimer::printLineTo(SERIAL_PORT_MONITOR, F("MultiZoneClock"), mode,
+      interrupts ? F("edgeButtonChecks") : F("pollButtonChecks"),
+      BENCHMARK_BUTTON_MILLIS, buttonConfig.numChecks());
+  BenchmarkTimer::printLineTo(SERIAL_PORT_MONITOR, F("MultiZoneClock"), mode,
+      interrupts ? F("edgePressMillis") : F("pollPressMillis"), 1,
+      benchmarkPressed
+          ? benchmarkPressedMillis - startMillis - BENCHMARK_EDGES[0].millis
+          : 0);
+}
+
+// Replay the BENCHMARK_BOUNCE_EDGES through the interrupts. Print the number
+// of dropped edges, and the number of LongPressed and RepeatPressed events,
+// which must be 0 for a click.
+void benchmarkBounce(uint16_t startMillis) {
+  uint8_t droppedEdges = buttonConfig.numDroppedEdges();
+  replayButtonEdges(BENCHMARK_BOUNCE_EDGES,
+      sizeof(BENCHMARK_BOUNCE_EDGES) / sizeof(BENCHMARK_BOUNCE_EDGES[0]),
+      true /*interrupts*/, startMillis);
+
+  uint8_t mode = (uint8_t) controller.getMode();
+  BenchmarkTimer::printLineTo(SERIAL_PORT_MONITOR, F("MultiZoneClock"), mode,
+      F("bounceDroppedEdges"), 1,
+      (uint8_t) (buttonConfig.numDroppedEdges() - droppedEdges));
+  BenchmarkTimer::printLineTo(SERIAL_PORT_MONITOR, F("MultiZoneClock"), mode,
+      F("bounceLongPresses"), 1, benchmarkLongPresses);
+}
+
+#endif
+
+// Benchmark each Mode, then restore the clock and the StoredInfo changed by
+// the walk through the Modes.
+void runBenchmark() {
+  benchmarkStartSeconds =
+      LocalDateTime::forComponents(2025, 1, 1, 0, 0, 0).toEpochSeconds();
+  acetime_t savedSeconds = systemClock.getNow();
+  uint32_t savedMillis = millis();
+  BenchmarkTimer::printHeaderTo(SERIAL_PORT_MONITOR);
+
+  benchmarkModes(controller, benchmarkMode, BENCHMARK_MAX_MODES);
+
+#if ENABLE_BUTTON_INTERRUPTS
+  benchmarkButtons(false /*interrupts*/, 10000);
+  benchmarkButtons(true /*interrupts*/, 20000);
+  benchmarkBounce(30000);
+#endif
+
+  // Restore the clock moved by the benchmark, and drop the StoredInfo saved
+  // when leaving each change Mode.
+  persistentStore.discard();
+  if (savedSeconds != LocalDateTime::kInvalidEpochSeconds) {
+    systemClock.setNow(savedSeconds + (millis() - savedMillis) / 1000);
+  }
+
+  SERIAL_PORT_MONITOR.print(F("# Max view Mode busBytesPerSecond: "));
+  SERIAL_PORT_MONITOR.print(benchmarkMaxViewBytesPerSecond);
+  SERIAL_PORT_MONITOR.print(F("; DISPLAY_BYTES_PER_SECOND_BUDGET: "));
+  SERIAL_PORT_MONITOR.println(DISPLAY_BYTES_PER_SECOND_BUDGET);
+  if (benchmarkOverBudget) {
+    SERIAL_PORT_MONITOR.println(
+        F("# Warning: display traffic exceeds "
+          "DISPLAY_BYTES_PER_SECOND_BUDGET"));
+  }
+
+#if defined(EPOXY_DUINO)
+  exit(0);
+#endif
+}
+
+#endif
+
 //-----------------------------------------------------------------------------
 // Main setup and loop
 //-----------------------------------------------------------------------------
@@ -616,7 +1023,8 @@ void setup() {
   TXLED0; // LED off
 #endif
 
-  if (ENABLE_SERIAL_DEBUG >= 1 || ENABLE_FPS_DEBUG >= 1) {
+  if (ENABLE_SERIAL_DEBUG >= 1 || ENABLE_FPS_DEBUG >= 1
+      || ENABLE_BENCHMARK >= 1) {
     SERIAL_PORT_MONITOR.begin(115200);
     while (!SERIAL_PORT_MONITOR); // Leonardo/Micro
   #if defined(EPOXY_DUINO)
@@ -657,6 +1065,10 @@ void setup() {
   CoroutineScheduler::list(SERIAL_PORT_MONITOR);
 #endif
 
+#if ENABLE_BENCHMARK
+  runBenchmark();
+#endif
+
   CoroutineScheduler::setup();
 
   if (ENABLE_SERIAL_DEBUG >= 1) {
@@ -666,8 +1078,13 @@ void setup() {
 
 void loop() {
   CoroutineScheduler::loop();
+  persistentStore.loop();
 
 #if SYSTEM_CLOCK_TYPE == SYSTEM_CLOCK_TYPE_LOOP
   systemClock.loop();
 #endif
+
+#if ENABLE_SYNC_POLICY
+  syncPolicy.loop();
+#endif
 }
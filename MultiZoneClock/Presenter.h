@@ -13,11 +13,19 @@
 #endif
 #if DISPLAY_TYPE == DISPLAY_TYPE_LCD
   #include <Adafruit_PCD8544.h>
+  #if ENABLE_LCD_SHADOW
+    #include "PCD8544Shadow.h"
+  #endif
 #else
   #include <SSD1306AsciiWire.h>
+  #if ENABLE_OLED_SHADOW
+    #include "SSD1306AsciiShadow.h"
+  #endif
 #endif
 #include "StoredInfo.h"
 #include "ClockInfo.h"
+#include "ZoneBatch.h"
+#include "ZoneCache.h"
 
 using namespace ace_time;
 using ace_common::printPad2To;
@@ -44,12 +52,38 @@ using ace_common::printPad2To;
  * rendering each frame. Normally, this would cause a flicker in the display.
  * However, it seems like the LCD pixels have so much latency that I don't see
  * any flickering at all. It works, so I'll just keep it like that for now.
+ *
+ * If ENABLE_LCD_SHADOW is enabled, the LCD is a PCD8544Shadow instead. The
+ * text is drawn with an opaque background, so the LCD becomes an overwriting
+ * display and is cleared only on a mode change. Then renderDisplay() sends
+ * only the changed columns of each bank, instead of the whole 504-byte buffer.
+ *
+ * On the OLED, the kViewDateTime screen is redrawn row by row. Each row
+ * declares the ClockInfo fields that it depends on (see the kFieldXxx masks),
+ * and only the rows whose fields changed since the previous frame are sent to
+ * the display. Since the seconds are not shown on that screen, most updates
+ * send nothing at all over the I2C bus. The number of bytes sent to the
+ * display is tracked in getFrameBytes() and getTotalBytes().
+ *
+ * If ENABLE_OLED_SHADOW is enabled, the OLED is an SSD1306AsciiShadow which
+ * buffers the frame, and renderDisplay() flushes only the changed column spans
+ * of each row to the display.
+ *
+ * The displayed dateTime is converted into all of the zones[] at once by a
+ * ZoneBatch, which caches the UTC offset and abbreviation of each zone in a
+ * ZoneWindow, so that the alternate times and the abbreviations do not
+ * search the zone processor on every frame. A window is replaced when its
+ * TimeZoneData is edited, or when the time leaves the window, i.e. at the next
+ * DST transition of that zone. The conversion is done here instead of in the
+ * Controller, because the alternate times follow the dateTime being edited in
+ * the Change modes.
  */
 class Presenter {
   public:
     /**
      * Constructor.
-     * @param zoneManager an instance of ZoneManager
+     * @param zoneManager ManualZoneManager, or a ZoneCache which wraps the
+     *        BasicZoneManager or ExtendedZoneManager
      * @param display either an OLED display or an LCD display, implementing
      *        the Print interface
      * @param isOverwriting if true, printing a character to a display
@@ -60,12 +94,16 @@ class Presenter {
       #if TIME_ZONE_TYPE == TIME_ZONE_TYPE_MANUAL
         ManualZoneManager& zoneManager,
       #elif TIME_ZONE_TYPE == TIME_ZONE_TYPE_BASIC
-        BasicZoneManager& zoneManager,
+        BasicZoneCache& zoneManager,
       #elif TIME_ZONE_TYPE == TIME_ZONE_TYPE_EXTENDED
-        ExtendedZoneManager& zoneManager,
+        ExtendedZoneCache& zoneManager,
       #endif
-      #if DISPLAY_TYPE == DISPLAY_TYPE_LCD
+      #if DISPLAY_TYPE == DISPLAY_TYPE_LCD && ENABLE_LCD_SHADOW
+        PCD8544Shadow& display,
+      #elif DISPLAY_TYPE == DISPLAY_TYPE_LCD
         Adafruit_PCD8544& display,
+      #elif ENABLE_OLED_SHADOW
+        SSD1306AsciiShadow& display,
       #else
         SSD1306Ascii& display,
       #endif
@@ -77,6 +115,7 @@ class Presenter {
       {}
 
     void updateDisplay() {
+      mFrameBytes = 0;
       if (needsClear()) {
         clearDisplay();
       }
@@ -86,8 +125,15 @@ class Presenter {
       }
 
       mPrevClockInfo = mClockInfo;
+      mTotalBytes += mFrameBytes;
     }
 
+    /** Number of bytes sent to the display by the last updateDisplay(). */
+    uint16_t getFrameBytes() const { return mFrameBytes; }
+
+    /** Number of bytes sent to the display since boot. */
+    uint32_t getTotalBytes() const { return mTotalBytes; }
+
     /**
      * The Controller uses this method to pass mode and time information to the
      * Presenter.
@@ -96,6 +142,17 @@ class Presenter {
       mClockInfo = clockInfo;
     }
 
+    /**
+     * Print the hit and miss counters of the zone cache, and of the zone
+     * processor caches.
+     */
+    void printZoneCacheStatsTo(Print& printer) const {
+      mZoneBatch.printStatsTo(printer);
+    #if TIME_ZONE_TYPE != TIME_ZONE_TYPE_MANUAL
+      mZoneManager.printStatsTo(printer);
+    #endif
+    }
+
   private:
     // Disable copy-constructor and assignment operator
     Presenter(const Presenter&) = delete;
@@ -106,9 +163,11 @@ class Presenter {
   private:
     void clearDisplay() {
     #if DISPLAY_TYPE == DISPLAY_TYPE_LCD
+      // Clears only the local buffer, which is sent by renderDisplay().
       mDisplay.clearDisplay();
     #else
       mDisplay.clear();
+      addRowBytes(kOledNumRows);
     #endif
     }
 
@@ -121,8 +180,13 @@ class Presenter {
     }
 
     void renderDisplay() {
-    #if DISPLAY_TYPE == DISPLAY_TYPE_LCD
+    #if DISPLAY_TYPE == DISPLAY_TYPE_LCD && ENABLE_LCD_SHADOW
+      mFrameBytes += mDisplay.flush();
+    #elif DISPLAY_TYPE == DISPLAY_TYPE_LCD
       mDisplay.display();
+      mFrameBytes += kLcdFrameBytes;
+    #elif ENABLE_OLED_SHADOW
+      mFrameBytes += mDisplay.flush();
     #else
       // OLED display updates immediately upon println(), no need to call
       // anything else.
@@ -131,7 +195,9 @@ class Presenter {
 
     void setFont() {
     #if DISPLAY_TYPE == DISPLAY_TYPE_LCD
-      // Use default font
+      // Use default font, with an opaque background so that a character
+      // overwrites the previous one.
+      mDisplay.setTextColor(BLACK, WHITE);
     #else
       //mDisplay.setFont(fixed_bold10x15);
       mDisplay.setFont(Adafruit5x7);
@@ -141,6 +207,7 @@ class Presenter {
     void setSize(uint8_t size) {
     #if DISPLAY_TYPE == DISPLAY_TYPE_LCD
       mDisplay.setTextSize(size);
+      mTextSize = size;
     #else
       if (size == 1) {
         mDisplay.set1X();
@@ -150,13 +217,45 @@ class Presenter {
     #endif
     }
 
-    void clearToEOL() {
+    /** Clear the rest of the current line, without moving the cursor. */
+    void clearRestOfLine() {
     #if DISPLAY_TYPE == DISPLAY_TYPE_LCD
-      // Not available, and not needed since the entire screen is clear
-      // on re-render.
+      int16_t x = mDisplay.getCursorX();
+      if (x < mDisplay.width()) {
+        mDisplay.fillRect(x, mDisplay.getCursorY(), mDisplay.width() - x,
+            8 * mTextSize, WHITE);
+      }
     #else
       mDisplay.clearToEOL();
+    #endif
+    }
+
+    void clearToEOL() {
+      clearRestOfLine();
       mDisplay.println();
+    }
+
+    /** Set the cursor to the start of the given text row. */
+    void setCursorRow(uint8_t row) {
+    #if DISPLAY_TYPE == DISPLAY_TYPE_LCD
+      mDisplay.setCursor(0 /*x*/, row * 8 /*y*/);
+    #else
+      mDisplay.setCursor(0 /*x pixels*/, row /*y row number*/);
+    #endif
+    }
+
+    /**
+     * Account for the bytes sent to the display for the given number of text
+     * rows. On the OLED, each row is written across the full width because
+     * clearToEOL() erases the remainder of the line. The LCD and the shadowed
+     * OLED are accounted for in renderDisplay() instead, when the frame is
+     * actually sent.
+     */
+    void addRowBytes(uint8_t rows) {
+    #if DISPLAY_TYPE == DISPLAY_TYPE_LCD || ENABLE_OLED_SHADOW
+      (void) rows;
+    #else
+      mFrameBytes += rows * kOledBytesPerRow;
     #endif
     }
 
@@ -191,6 +290,58 @@ class Presenter {
       return mClockInfo != mPrevClockInfo;
     }
 
+    /**
+     * Return the bit mask of the kFieldXxx fields used by the kViewDateTime
+     * screen which changed since the previous frame. A change in the blinking
+     * state is reported as a change of the field being edited. Everything is
+     * marked as changed if the display was cleared.
+     */
+    uint8_t changedDateTimeFields() const {
+      if (! mIsOverwriting || needsClear()) return kFieldAll;
+
+      const ZonedDateTime& dateTime = mClockInfo.dateTime;
+      const ZonedDateTime& prevDateTime = mPrevClockInfo.dateTime;
+      if (dateTime.isError() || prevDateTime.isError()) return kFieldAll;
+
+      uint8_t fields = 0;
+      if (dateTime.hour() != prevDateTime.hour()
+          || dateTime.minute() != prevDateTime.minute()
+          || dateTime.timeOffset() != prevDateTime.timeOffset()) {
+        fields |= kFieldTime;
+      }
+      if (dateTime.localDateTime().localDate()
+          != prevDateTime.localDateTime().localDate()) {
+        fields |= kFieldDate;
+      }
+      if (mClockInfo.hourMode != mPrevClockInfo.hourMode) {
+        fields |= kFieldHourMode;
+      }
+      for (uint8_t i = 0; i < NUM_TIME_ZONES; ++i) {
+        if (mClockInfo.zones[i] != mPrevClockInfo.zones[i]) {
+          fields |= (kFieldZone0 << i);
+        }
+      }
+
+      if (mClockInfo.blinkShowState != mPrevClockInfo.blinkShowState
+          || mClockInfo.suppressBlink != mPrevClockInfo.suppressBlink) {
+        switch (mClockInfo.mode) {
+          case Mode::kChangeHour:
+          case Mode::kChangeMinute:
+            fields |= kFieldTime;
+            break;
+          case Mode::kChangeYear:
+          case Mode::kChangeMonth:
+          case Mode::kChangeDay:
+            fields |= kFieldDate;
+            break;
+          default:
+            break;
+        }
+      }
+
+      return fields;
+    }
+
     /** Update the display settings, e.g. brightness, backlight, etc. */
     void updateDisplaySettings() {
     #if DISPLAY_TYPE == DISPLAY_TYPE_LCD
@@ -253,6 +404,8 @@ class Presenter {
       }
       setFont();
 
+      // The kViewDateTime screen accounts for its own rows.
+      bool isFullRedraw = true;
       switch (mClockInfo.mode) {
         case Mode::kViewDateTime:
         case Mode::kChangeYear:
@@ -262,6 +415,7 @@ class Presenter {
         case Mode::kChangeMinute:
         case Mode::kChangeSecond:
           displayDateTimeMode();
+          isFullRedraw = false;
           break;
 
         case Mode::kViewTimeZone:
@@ -307,6 +461,13 @@ class Presenter {
           break;
       }
 
+    #if DISPLAY_TYPE == DISPLAY_TYPE_OLED
+      if (isFullRedraw) {
+        addRowBytes(mDisplay.row());
+      }
+    #else
+      (void) isFullRedraw;
+    #endif
       renderDisplay();
     }
 
@@ -318,29 +479,38 @@ class Presenter {
       const ZonedDateTime& dateTime = mClockInfo.dateTime;
       if (dateTime.isError()) {
         mDisplay.println(F("<Error>"));
+        addRowBytes(1);
         return;
       }
 
-      // Display primary time in large font.
-      displayLargeTime(dateTime);
+      uint8_t changed = changedDateTimeFields();
+      if (changed == 0) return;
+      mZoneBatch.convert(
+          mZoneManager, dateTime.toEpochSeconds(), mClockInfo.zones);
 
-      // Display alternates in normal font.
-      TimeZone tz = mZoneManager.createForTimeZoneData(mClockInfo.zones[1]);
-      ZonedDateTime altDateTime = dateTime.convertToTimeZone(tz);
-      displayDateChangeIndicator(dateTime, altDateTime);
-      displayTimeWithAbbrev(altDateTime);
-
-      tz = mZoneManager.createForTimeZoneData(mClockInfo.zones[2]);
-      altDateTime = dateTime.convertToTimeZone(tz);
-      displayDateChangeIndicator(dateTime, altDateTime);
-      displayTimeWithAbbrev(altDateTime);
+      // Display primary time in large font, on rows 0 and 1.
+      if (changed & kLargeTimeRowFields) {
+        setCursorRow(0);
+        displayLargeTime(dateTime, mZoneBatch.extra(0));
+        addRowBytes(2);
+      }
 
-      tz = mZoneManager.createForTimeZoneData(mClockInfo.zones[3]);
-      altDateTime = dateTime.convertToTimeZone(tz);
-      displayDateChangeIndicator(dateTime, altDateTime);
-      displayTimeWithAbbrev(altDateTime);
+      // Display alternates in normal font, one per row.
+      for (uint8_t i = 1; i < NUM_TIME_ZONES; ++i) {
+        if (changed & (kAltTimeRowFields | (kFieldZone0 << i))) {
+          setCursorRow(i + 1);
+          const ZonedDateTime& altDateTime = mZoneBatch.dateTime(i);
+          displayDateChangeIndicator(dateTime, altDateTime);
+          displayTimeWithAbbrev(altDateTime, mZoneBatch.extra(i));
+          addRowBytes(1);
+        }
+      }
 
-      displayHumanDate(dateTime);
+      if (changed & kHumanDateRowFields) {
+        setCursorRow(NUM_TIME_ZONES + 1);
+        displayHumanDate(dateTime);
+        addRowBytes(1);
+      }
     }
 
     // Print a '>' or '<' if the date of the target time is different.
@@ -404,7 +574,8 @@ class Presenter {
       clearToEOL();
     }
 
-    void displayLargeTime(const ZonedDateTime& dateTime) {
+    void displayLargeTime(
+        const ZonedDateTime& dateTime, const ZonedExtra& extra) {
       setSize(2);
       if (shouldShowFor(Mode::kChangeHour)) {
         uint8_t hour = dateTime.hour();
@@ -432,17 +603,18 @@ class Presenter {
       if (mClockInfo.hourMode == ClockInfo::kTwelve) {
         setSize(1);
         mDisplay.print((dateTime.hour() < 12) ? "AM" : "PM");
-        mDisplay.clearToEOL();
+        clearRestOfLine();
       }
 
       // TimeZone
       setSize(1);
       setCursorUnderAmPm();
-      displayTimeZoneAbbrev(dateTime);
+      displayTimeZoneAbbrev(dateTime, extra);
       clearToEOL();
     }
 
-    void displayTimeWithAbbrev(const ZonedDateTime& dateTime) {
+    void displayTimeWithAbbrev(
+        const ZonedDateTime& dateTime, const ZonedExtra& extra) {
       if (shouldShowFor(Mode::kChangeHour)) {
         uint8_t hour = dateTime.hour();
         if (mClockInfo.hourMode == ClockInfo::kTwelve) {
@@ -469,22 +641,22 @@ class Presenter {
       }
 
       mDisplay.print(' ');
-      displayTimeZoneAbbrev(dateTime);
+      displayTimeZoneAbbrev(dateTime, extra);
       clearToEOL();
     }
 
     // Timezone abbreviation. For Manual timezone, the abbreviation is just
     // 'STD' or 'DST' which is not useful when multiple time zones are
     // displayed. Instead, print out the short name, which will be "+hh:mm"
-    // for a manual timezone.
-    void displayTimeZoneAbbrev(const ZonedDateTime& dateTime) {
+    // for a manual timezone. The abbreviation of other timezones comes from
+    // the cached ZonedExtra of the zone.
+    void displayTimeZoneAbbrev(
+        const ZonedDateTime& dateTime, const ZonedExtra& extra) {
       const TimeZone& tz = dateTime.timeZone();
       if (tz.getType() == TimeZone::kTypeManual) {
         tz.printShortTo(mDisplay);
       } else {
-        ZonedExtra ze = ZonedExtra::forEpochSeconds(
-            dateTime.toEpochSeconds(), tz);
-        mDisplay.print(ze.abbrev());
+        mDisplay.print(extra.abbrev());
       }
     }
 
@@ -649,24 +821,21 @@ class Presenter {
     #if DISPLAY_TYPE == DISPLAY_TYPE_LCD
       mDisplay.print(F("Backlight:"));
       if (shouldShowFor(Mode::kChangeSettingsBacklight)) {
-        mDisplay.println(mClockInfo.backlightLevel);
-      } else {
-        mDisplay.println(' ');
+        mDisplay.print(mClockInfo.backlightLevel);
       }
+      clearToEOL();
 
       mDisplay.print(F("Contrast:"));
       if (shouldShowFor(Mode::kChangeSettingsContrast)) {
-        mDisplay.println(mClockInfo.contrast);
-      } else {
-        mDisplay.println(' ');
+        mDisplay.print(mClockInfo.contrast);
       }
+      clearToEOL();
 
       mDisplay.print(F("Bias:"));
       if (shouldShowFor(Mode::kChangeSettingsBias)) {
-        mDisplay.println(mClockInfo.bias);
-      } else {
-        mDisplay.println(' ');
+        mDisplay.print(mClockInfo.bias);
       }
+      clearToEOL();
 
     #else
       mDisplay.print(F("Contrast:"));
@@ -714,6 +883,17 @@ class Presenter {
       mDisplay.print(F("S:"));
       displayTimePeriodHMS(mClockInfo.clockSkew);
       clearToEOL();
+
+    #if TIME_ZONE_TYPE != TIME_ZONE_TYPE_MANUAL
+      // Print the hits/misses/evictions of the pinned and scratch zone
+      // processor caches.
+      mDisplay.print(F("P:"));
+      mZoneManager.printStatsTo(mDisplay, mZoneManager.pinnedStats());
+      clearToEOL();
+      mDisplay.print(F("B:"));
+      mZoneManager.printStatsTo(mDisplay, mZoneManager.scratchStats());
+      clearToEOL();
+    #endif
     }
 
     void displayTimePeriodHMS(const TimePeriod& tp) {
@@ -741,19 +921,46 @@ class Presenter {
   private:
   #if DISPLAY_TYPE == DISPLAY_TYPE_LCD
     static const uint16_t kLcdBacklightValues[];
+
+    /** Size of the PCD8544 frame buffer (84x48 pixels), sent on each render. */
+    static uint16_t const kLcdFrameBytes = 504;
   #else
     static const uint8_t kOledContrastValues[];
+
+    /** Bytes needed to write one 8-pixel row across the 128-pixel width. */
+    static uint8_t const kOledBytesPerRow = 128;
+
+    /** Number of 8-pixel rows on the 128x64 OLED. */
+    static uint8_t const kOledNumRows = 8;
   #endif
 
+    // ClockInfo fields used by the rows of the kViewDateTime screen.
+    static uint8_t const kFieldTime = 0x01; // hour, minute, UTC offset
+    static uint8_t const kFieldDate = 0x02;
+    static uint8_t const kFieldHourMode = 0x04;
+    static uint8_t const kFieldZone0 = 0x08; // zones[i] is (kFieldZone0 << i)
+    static uint8_t const kFieldAll = 0xFF;
+
+    // Fields that each row of the kViewDateTime screen depends on.
+    static uint8_t const kLargeTimeRowFields =
+        kFieldTime | kFieldHourMode | kFieldZone0;
+    static uint8_t const kAltTimeRowFields =
+        kFieldTime | kFieldDate | kFieldHourMode | kFieldZone0;
+    static uint8_t const kHumanDateRowFields = kFieldDate;
+
   #if TIME_ZONE_TYPE == TIME_ZONE_TYPE_MANUAL
     ManualZoneManager& mZoneManager;
   #elif TIME_ZONE_TYPE == TIME_ZONE_TYPE_BASIC
-    BasicZoneManager& mZoneManager;
+    BasicZoneCache& mZoneManager;
   #elif TIME_ZONE_TYPE == TIME_ZONE_TYPE_EXTENDED
-    ExtendedZoneManager& mZoneManager;
+    ExtendedZoneCache& mZoneManager;
   #endif
-  #if DISPLAY_TYPE == DISPLAY_TYPE_LCD
+  #if DISPLAY_TYPE == DISPLAY_TYPE_LCD && ENABLE_LCD_SHADOW
+    PCD8544Shadow& mDisplay;
+  #elif DISPLAY_TYPE == DISPLAY_TYPE_LCD
     Adafruit_PCD8544& mDisplay;
+  #elif ENABLE_OLED_SHADOW
+    SSD1306AsciiShadow& mDisplay;
   #else
     SSD1306Ascii& mDisplay;
   #endif
@@ -761,6 +968,17 @@ class Presenter {
     ClockInfo mClockInfo;
     ClockInfo mPrevClockInfo;
     bool const mIsOverwriting;
+
+  #if DISPLAY_TYPE == DISPLAY_TYPE_LCD
+    uint8_t mTextSize = 1;
+  #endif
+
+    uint16_t mFrameBytes = 0;
+    uint32_t mTotalBytes = 0;
+
+    // Conversion of the dateTime into each of the zones[], with a cache of
+    // the UTC offset and abbreviation of each zone.
+    ZoneBatch<NUM_TIME_ZONES> mZoneBatch;
 };
 
 #endif
@@ -0,0 +1,93 @@
+#ifndef MULTI_ZONE_CLOCK_ZONE_BATCH_H
+#define MULTI_ZONE_CLOCK_ZONE_BATCH_H
+
+#include <AceTime.h>
+#include "ZoneWindow.h"
+
+using namespace ace_time;
+
+/**
+ * Converts a single epochSeconds into SIZE time zones in one pass, and keeps
+ * the resulting ZonedDateTime and the ZonedExtra (UTC offset, abbreviation) of
+ * each zone.
+ *
+ * The conversion runs in 2 passes over the zones. The first pass refreshes
+ * the ZoneWindow of each zone whose window has expired, so that the zone
+ * processors are searched back to back, and only on a miss. The second pass
+ * advances the ZonedDateTime of each zone through its ZoneWindow, which
+ * increments the second field within a minute, and converts the epochSeconds
+ * through the public ZonedDateTime::forEpochSeconds() only when the minute
+ * rolls over.
+ *
+ * Hits and misses of the zone windows are counted and can be printed with
+ * printStatsTo().
+ */
+template <uint8_t SIZE>
+class ZoneBatch {
+  public:
+    /**
+     * Convert epochSeconds into each of the zones[], resolving a TimeZoneData
+     * into a TimeZone through the zoneManager only when its window expired.
+     */
+    template <typename T_ZONE_MANAGER>
+    void convert(
+        T_ZONE_MANAGER& zoneManager,
+        acetime_t epochSeconds,
+        const TimeZoneData zones[]) {
+      for (uint8_t i = 0; i < SIZE; ++i) {
+        ZoneWindow& window = mWindows[i];
+        if (window.isValid(epochSeconds, zones[i])) {
+          mNumHits++;
+        } else {
+          mNumMisses++;
+          TimeZone tz = zoneManager.createForTimeZoneData(zones[i]);
+          window.reset(epochSeconds, zones[i], tz);
+        }
+      }
+      convertAll(epochSeconds);
+    }
+
+    /** Convert epochSeconds into each of the already resolved zones[]. */
+    void convert(acetime_t epochSeconds, const TimeZone zones[]) {
+      for (uint8_t i = 0; i < SIZE; ++i) {
+        ZoneWindow& window = mWindows[i];
+        TimeZoneData zoneData = zones[i].toTimeZoneData();
+        if (window.isValid(epochSeconds, zoneData)) {
+          mNumHits++;
+        } else {
+          mNumMisses++;
+          window.reset(epochSeconds, zoneData, zones[i]);
+        }
+      }
+      convertAll(epochSeconds);
+    }
+
+    /** The ZonedDateTime of zone i from the last convert(). */
+    const ZonedDateTime& dateTime(uint8_t i) const {
+      return mWindows[i].dateTime();
+    }
+
+    /** The UTC offset and abbreviation of zone i from the last convert(). */
+    const ZonedExtra& extra(uint8_t i) const { return mWindows[i].extra(); }
+
+    /** Print the hit and miss counters of the zone windows. */
+    void printStatsTo(Print& printer) const {
+      printer.print(F("zone cache: hits "));
+      printer.print(mNumHits);
+      printer.print(F("; misses "));
+      printer.println(mNumMisses);
+    }
+
+  private:
+    void convertAll(acetime_t epochSeconds) {
+      for (uint8_t i = 0; i < SIZE; ++i) {
+        mWindows[i].forEpochSeconds(epochSeconds);
+      }
+    }
+
+    ZoneWindow mWindows[SIZE];
+    uint32_t mNumHits = 0;
+    uint32_t mNumMisses = 0;
+};
+
+#endif
@@ -0,0 +1,151 @@
+#ifndef MULTI_ZONE_CLOCK_ZONE_WINDOW_H
+#define MULTI_ZONE_CLOCK_ZONE_WINDOW_H
+
+#include <string.h> // strcmp()
+#include <AceTime.h>
+
+using namespace ace_time;
+
+/**
+ * Caches the UTC offset and abbreviation of a time zone over a window of
+ * epoch seconds which contains no DST transition, so that the ZonedExtra and
+ * the ZonedDateTime of the current time need not be recalculated through the
+ * zone processor on every update.
+ *
+ * The window starts at the epochSeconds given to reset(), and lasts until the
+ * next change of UTC offset or abbreviation, or kMaxWindowSeconds, whichever
+ * comes first. The end of the window is found by looking up the ZonedExtra at
+ * kMaxWindowSeconds, then bisecting down to the transition if it differs. A
+ * transition is crossed only twice a year, so the bisection is rare. The
+ * kMaxWindowSeconds is far shorter than the interval between any two
+ * transitions of a zone, so a pair of transitions cannot hide inside it.
+ *
+ * Within the window, forEpochSeconds() advances the previous ZonedDateTime by
+ * incrementing its second field, and falls back to the public
+ * ZonedDateTime::forEpochSeconds() when the minute rolls over, or when the
+ * time moves backwards. AceTime does not offer a public constructor of a
+ * ZonedDateTime from an OffsetDateTime, so the cached UTC offset cannot be
+ * applied directly; it is used only to find the end of the window.
+ *
+ * Usage:
+ *
+ * @code
+ * if (! zoneWindow.isValid(nowSeconds, zoneData)) {
+ *   TimeZone tz = zoneManager.createForTimeZoneData(zoneData);
+ *   zoneWindow.reset(nowSeconds, zoneData, tz);
+ * }
+ * ZonedDateTime dateTime = zoneWindow.forEpochSeconds(nowSeconds);
+ * @endcode
+ */
+class ZoneWindow {
+  public:
+    /** Maximum length of the window. */
+    static acetime_t const kMaxWindowSeconds = 86400;
+
+    /**
+     * Return true if the window was created for zoneData and contains
+     * epochSeconds.
+     */
+    bool isValid(acetime_t epochSeconds, const TimeZoneData& zoneData) const {
+      return mIsValid
+          && epochSeconds >= mStartSeconds
+          && epochSeconds < mUntilSeconds
+          && zoneData == mZoneData;
+    }
+
+    /** Start a new window at epochSeconds for the time zone tz. */
+    void reset(
+        acetime_t epochSeconds,
+        const TimeZoneData& zoneData,
+        const TimeZone& tz) {
+      mZoneData = zoneData;
+      mTimeZone = tz;
+      mExtra = ZonedExtra::forEpochSeconds(epochSeconds, tz);
+      mIsValid = ! mExtra.isError();
+      if (! mIsValid) {
+        mDateTime = ZonedDateTime::forEpochSeconds(epochSeconds, tz);
+        return;
+      }
+
+      mStartSeconds = epochSeconds;
+      mUntilSeconds = findWindowEnd(epochSeconds);
+      mDateTime = toDateTime(epochSeconds);
+      mPrevSeconds = epochSeconds;
+    }
+
+    /**
+     * Return the ZonedDateTime of epochSeconds. If the window is not valid,
+     * this returns the ZonedDateTime calculated by the last reset(), which is
+     * an error if the time zone could not be resolved.
+     */
+    const ZonedDateTime& forEpochSeconds(acetime_t epochSeconds) {
+      if (! mIsValid) return mDateTime;
+
+      acetime_t delta = epochSeconds - mPrevSeconds;
+      if (delta == 0) return mDateTime;
+
+      uint8_t second = mDateTime.second();
+      if (delta > 0 && second + delta < 60) {
+        mDateTime.second(second + delta);
+      } else {
+        mDateTime = toDateTime(epochSeconds);
+      }
+      mPrevSeconds = epochSeconds;
+      return mDateTime;
+    }
+
+    /** The ZonedDateTime returned by the last forEpochSeconds(). */
+    const ZonedDateTime& dateTime() const { return mDateTime; }
+
+    /** Return true if the last reset() resolved the time zone. */
+    bool isResolved() const { return mIsValid; }
+
+    /** The time zone given to the last reset(). */
+    const TimeZone& timeZone() const { return mTimeZone; }
+
+    /** The UTC offset and abbreviation of the current window. */
+    const ZonedExtra& extra() const { return mExtra; }
+
+    /** End (exclusive) of the current window. */
+    acetime_t untilSeconds() const { return mUntilSeconds; }
+
+  private:
+    ZonedDateTime toDateTime(acetime_t epochSeconds) const {
+      return ZonedDateTime::forEpochSeconds(epochSeconds, mTimeZone);
+    }
+
+    /** Return true if epochSeconds has the same offset and abbreviation. */
+    bool isSameRule(acetime_t epochSeconds) const {
+      ZonedExtra extra = ZonedExtra::forEpochSeconds(epochSeconds, mTimeZone);
+      return extra.timeOffset() == mExtra.timeOffset()
+          && strcmp(extra.abbrev(), mExtra.abbrev()) == 0;
+    }
+
+    /** Find the first epochSeconds after start which has a different rule. */
+    acetime_t findWindowEnd(acetime_t start) const {
+      acetime_t same = start;
+      acetime_t different = start + kMaxWindowSeconds;
+      if (isSameRule(different)) return different;
+
+      while (different - same > 1) {
+        acetime_t mid = same + (different - same) / 2;
+        if (isSameRule(mid)) {
+          same = mid;
+        } else {
+          different = mid;
+        }
+      }
+      return different;
+    }
+
+    TimeZoneData mZoneData;
+    TimeZone mTimeZone;
+    ZonedExtra mExtra;
+    ZonedDateTime mDateTime;
+    acetime_t mStartSeconds = 0;
+    acetime_t mUntilSeconds = 0;
+    acetime_t mPrevSeconds = 0;
+    bool mIsValid = false;
+};
+
+#endif
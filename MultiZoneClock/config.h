@@ -14,11 +14,80 @@
 #define ENABLE_SERIAL_DEBUG 0
 #endif
 
+// Set to 1 to benchmark the Controller and Presenter in each Mode at the end
+// of setup(), printing CSV lines to SERIAL_PORT_MONITOR. On EpoxyDuino, run
+// `make benchmark`, which exits after the benchmark.
+#ifndef ENABLE_BENCHMARK
+#define ENABLE_BENCHMARK 0
+#endif
+
+// Set to 1 to read the digital buttons through pin-change interrupts, which
+// queue the edges for AceButton (see EdgeButtonConfig.h), so that the buttons
+// are checked only while a press is in progress, instead of every 6 ms. Both
+// MODE_BUTTON_PIN and CHANGE_BUTTON_PIN must support attachInterrupt().
+#ifndef ENABLE_BUTTON_INTERRUPTS
+#define ENABLE_BUTTON_INTERRUPTS 0
+#endif
+
 // Set to >= 1 to enable periodic calculation of the frames-per-second.
 #ifndef ENABLE_FPS_DEBUG
 #define ENABLE_FPS_DEBUG 0
 #endif
 
+// Set to 1 to render the OLED through the 1 kB SSD1306AsciiShadow page buffer,
+// which sends only the changed column spans to the display. Too much RAM for
+// most AVR boards.
+#ifndef ENABLE_OLED_SHADOW
+  #if defined(ARDUINO_ARCH_AVR)
+    #define ENABLE_OLED_SHADOW 0
+  #else
+    #define ENABLE_OLED_SHADOW 1
+  #endif
+#endif
+
+// Set to 1 to render the LCD through the PCD8544Shadow, which sends only the
+// changed columns of each bank instead of the full 504-byte buffer. Needs an
+// extra 504 bytes of RAM.
+#ifndef ENABLE_LCD_SHADOW
+  #if defined(ARDUINO_ARCH_AVR)
+    #define ENABLE_LCD_SHADOW 0
+  #else
+    #define ENABLE_LCD_SHADOW 1
+  #endif
+#endif
+
+// Set to 1 to count the bytes, bus transactions and cursor moves sent to the
+// OLED, by placing an SSD1306AsciiCounter in front of it.
+#ifndef ENABLE_DISPLAY_COUNTER
+#define ENABLE_DISPLAY_COUNTER 0
+#endif
+
+// Steady-state display traffic budget, in bytes per second, of each view
+// Mode. The traffic is measured by the SSD1306AsciiCounter if enabled,
+// otherwise by Presenter::getFrameBytes().
+// These values are provisional estimates, not yet recorded from a run, so
+// `make benchmark` only prints a warning when the traffic exceeds them, and
+// does not fail. Record the budget from the "Max view Mode busBytesPerSecond"
+// line of the benchmark plus a margin, before making it fail the benchmark.
+#ifndef DISPLAY_BYTES_PER_SECOND_BUDGET
+#define DISPLAY_BYTES_PER_SECOND_BUDGET 768
+#endif
+
+// Number of StoredInfo slots in the EEPROM, written in rotation so that each
+// save wears a different slot, and a torn save leaves the previous slot intact.
+// At least 2. The flash-emulated EEPROM of the ESP8266, ESP32 and STM32
+// rewrites its whole buffer on each commit, so more slots do not reduce wear.
+// All the slots also live in that one flash sector, which is erased and
+// rewritten by the commit, so a power loss during a commit can lose every
+// slot. The torn save guarantee holds only on the AVR (and EpoxyDuino).
+#ifndef NUM_STORED_INFO_SLOTS
+  #if defined(ARDUINO_ARCH_AVR) || defined(EPOXY_DUINO)
+    #define NUM_STORED_INFO_SLOTS 8
+  #else
+    #define NUM_STORED_INFO_SLOTS 2
+  #endif
+#endif
+
 // Set to 1 to force the ClockInfo to its initial state
 #define FORCE_INITIALIZE 0
 
@@ -75,6 +144,22 @@
   #define SYSTEM_CLOCK SystemClockCoroutine
 #endif
 
+// Range of the sync period of the SystemClock, adapted by the SyncPolicy to
+// the drift measured by the previous syncs, so that the clock skew stays under
+// SYNC_SKEW_BOUND_SECONDS (at least 2, since the skew is in whole seconds).
+// Failed syncs are retried from SYNC_PERIOD_MIN_SECONDS, backing off
+// exponentially. An NTP build does not use the SyncPolicy, whose syncs block,
+// and syncs every SYNC_PERIOD_MIN_SECONDS instead.
+#ifndef SYNC_PERIOD_MIN_SECONDS
+  #define SYNC_PERIOD_MIN_SECONDS 60
+#endif
+#ifndef SYNC_PERIOD_MAX_SECONDS
+  #define SYNC_PERIOD_MAX_SECONDS 3600
+#endif
+#ifndef SYNC_SKEW_BOUND_SECONDS
+  #define SYNC_SKEW_BOUND_SECONDS 2
+#endif
+
 // Button options: either digital ButtonConfig or analog LadderButtonConfig.
 // AVR: 10-bit analog pin
 // ESP8266: 10-bit analog pin
@@ -14,7 +14,9 @@
 #include "ClockInfo.h"
 #include "StoredInfo.h"
 #include "PersistentStore.h"
+#include "PhaseEstimator.h"
 #include "Presenter.h"
+#include "ZoneWindow.h"
 
 using namespace ace_time;
 using namespace ace_time::clock;
@@ -35,6 +37,7 @@ class Controller {
     // Number of minutes to use for a DST offset.
     static const int16_t kDstOffsetMinutes = 60;
 
+
     /**
      * Constructor.
      * @param clock source of the current time
@@ -88,20 +91,67 @@ class Controller {
     }
 
     /**
-     * This should be called every 0.1s to support blinking mode and to avoid
-     * noticeable drift against the RTC which has a 1 second resolution.
+     * Return true if update() should be called. The ClockInfo can change only
+     * when the SystemClock rolls over to the next second, when the blinking
+     * state toggles in a Change mode, or when a button is pressed. Between
+     * those events, this returns false using only millis(), so it can be
+     * polled on every iteration of loop().
+     *
+     * The PhaseEstimator predicts the rollover, and the SystemClock is
+     * polled only from slightly ahead of it until its seconds change.
      */
-    void update() {
-      if (mClockInfo.mode == Mode::kUnknown) return;
+    bool isUpdateDue() {
+      if (mUpdateRequested) return true;
+
+      uint16_t nowMillis = millis();
+      if ((uint16_t) (nowMillis - mLastUpdateMillis)
+          >= PhaseEstimator::kSecondMillis) {
+        return true;
+      }
+      if (mPhaseEstimator.isBeforeWindow(nowMillis)) return false;
+
+      if (mClock.getNow() != mPrevSeconds) return true;
+      mPhaseEstimator.observeOldSecond(nowMillis);
+      return false;
+    }
+
+    /** Return the current Mode, used by the benchmark. */
+    Mode getMode() const { return mClockInfo.mode; }
+
+    /**
+     * Update the ClockInfo from the clock and pass it to the Presenter,
+     * without rendering the display.
+     */
+    void updateClockInfo() {
       updateDateTime();
       updatePresenter();
+    }
+
+    /**
+     * Update the ClockInfo and render it. This should be called whenever
+     * isUpdateDue() returns true. It can be called more often (e.g. every
+     * 0.1s), but the output changes only at the events tracked by
+     * isUpdateDue().
+     */
+    void update() {
+      if (mClockInfo.mode == Mode::kUnknown) return;
+      mUpdateRequested = false;
+      mLastUpdateMillis = millis();
+      updateClockInfo();
       mPresenter.updateDisplay();
+      mPhaseEstimator.recordRender(millis());
     }
 
+    /** Estimator of the rollover of the SystemClock, with its statistics. */
+    PhaseEstimator& getPhaseEstimator() { return mPhaseEstimator; }
+
     void updateBlinkState () {
       mClockInfo.blinkShowState = !mClockInfo.blinkShowState;
       mChangingClockInfo.blinkShowState = !mChangingClockInfo.blinkShowState;
       updatePresenter();
+
+      // The blinking state is rendered only in the Change modes.
+      if (mClockInfo.mode >= Mode::kChangeYear) mUpdateRequested = true;
     }
 
     /**
@@ -217,6 +267,7 @@ class Controller {
       #endif
 
       mChangingClockInfo.mode = mClockInfo.mode;
+      mUpdateRequested = true;
     }
 
     /** Toggle edit mode. The editable field will start blinking. */
@@ -300,6 +351,7 @@ class Controller {
       }
 
       mChangingClockInfo.mode = mClockInfo.mode;
+      mUpdateRequested = true;
     }
 
     // If the system clock hasn't been initialized, set the initial
@@ -357,6 +409,8 @@ class Controller {
         default:
           break;
       }
+
+      mUpdateRequested = true;
     }
 
     void handleChangeButtonPress() {
@@ -521,6 +575,7 @@ class Controller {
       #endif
           mClockInfo.suppressBlink = false;
           mChangingClockInfo.suppressBlink = false;
+          mUpdateRequested = true;
           break;
 
         default:
@@ -546,8 +601,13 @@ class Controller {
   private:
     void updateDateTime() {
       acetime_t nowSeconds = mClock.getNow();
-      TimeZone tz = mZoneManager.createForTimeZoneData(mClockInfo.timeZoneData);
-      mClockInfo.dateTime = ZonedDateTime::forEpochSeconds(nowSeconds, tz);
+      trackRollover(nowSeconds);
+      const TimeZoneData& zoneData = mClockInfo.timeZoneData;
+      if (! mZoneWindow.isValid(nowSeconds, zoneData)) {
+        TimeZone tz = mZoneManager.createForTimeZoneData(zoneData);
+        mZoneWindow.reset(nowSeconds, zoneData, tz);
+      }
+      mClockInfo.dateTime = mZoneWindow.forEpochSeconds(nowSeconds);
 
       //acetime_t lastSync = mClock.getLastSyncTime();
       int32_t secondsSinceSyncAttempt = mClock.getSecondsSinceSyncAttempt();
@@ -576,6 +636,14 @@ class Controller {
       }
     }
 
+    /** Feed the millis() of a new second of the clock to the PhaseEstimator. */
+    void trackRollover(acetime_t nowSeconds) {
+      if (nowSeconds == mPrevSeconds) return;
+
+      mPrevSeconds = nowSeconds;
+      mPhaseEstimator.observeRollover(mLastUpdateMillis);
+    }
+
     void updatePresenter() {
       ClockInfo* clockInfo;
 
@@ -664,7 +732,7 @@ class Controller {
       }
       StoredInfo storedInfo;
       storedInfoFromClockInfo(storedInfo, mClockInfo);
-      mPersistentStore.writeStoredInfo(storedInfo);
+      mPersistentStore.saveStoredInfo(storedInfo);
     }
 
     /** Convert StoredInfo to ClockInfo. */
@@ -768,6 +836,9 @@ class Controller {
 
     TimeZoneData mInitialTimeZoneData;
 
+    // UTC offset of the time zone, valid until its next DST transition.
+    ZoneWindow mZoneWindow;
+
   #if ENABLE_DHT22
     DHT* const mDht;
   #endif
@@ -777,6 +848,12 @@ class Controller {
 
     uint16_t mZoneRegistryIndex;
     bool mSecondFieldCleared;
+
+    // State of the update scheduling in isUpdateDue().
+    PhaseEstimator mPhaseEstimator;
+    acetime_t mPrevSeconds = 0;
+    uint16_t mLastUpdateMillis = 0;
+    bool mUpdateRequested = true;
 };
 
 #endif
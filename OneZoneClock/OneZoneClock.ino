@@ -49,6 +49,11 @@
 
 #include "PersistentStore.h"
 #include "Controller.h"
+#include "Benchmark.h"
+#include "SyncPolicy.h"
+#if DISPLAY_TYPE == DISPLAY_TYPE_OLED
+  #include "SSD1306AsciiCounter.h"
+#endif
 
 using namespace ace_button;
 using namespace ace_routine;
@@ -184,7 +189,29 @@ static ManualZoneManager zoneManager;
   #error Unknown BACKUP_TIME_SOURCE_TYPE
 #endif
 
-SYSTEM_CLOCK systemClock(refClock, backupClock, 60 /*syncPeriod*/);
+// The SyncPolicy forces each sync with a blocking read of the reference clock,
+// which would stall loop() for up to the request timeout of the NtpClock. So
+// an NTP build keeps the fixed SYNC_PERIOD_MIN_SECONDS of the systemClock,
+// whose coroutine syncs without blocking. Without a reference clock, there is
+// nothing to sync with.
+#if TIME_SOURCE_TYPE == TIME_SOURCE_TYPE_NONE \
+    || TIME_SOURCE_TYPE == TIME_SOURCE_TYPE_NTP
+  #define ENABLE_SYNC_POLICY 0
+  #define SYSTEM_CLOCK_SYNC_SECONDS SYNC_PERIOD_MIN_SECONDS
+#else
+  #define ENABLE_SYNC_POLICY 1
+  #define SYSTEM_CLOCK_SYNC_SECONDS SYNC_PERIOD_MAX_SECONDS
+#endif
+
+SYSTEM_CLOCK systemClock(
+    refClock, backupClock, SYSTEM_CLOCK_SYNC_SECONDS /*syncPeriod*/);
+
+#if ENABLE_SYNC_POLICY
+// Syncs the systemClock as often as its measured drift requires, between
+// SYNC_PERIOD_MIN_SECONDS and the SYNC_PERIOD_MAX_SECONDS of the systemClock.
+SyncPolicy syncPolicy(systemClock, SYNC_PERIOD_MIN_SECONDS,
+    SYNC_PERIOD_MAX_SECONDS, SYNC_SKEW_BOUND_SECONDS);
+#endif
 
 void setupClocks() {
 #if TIME_SOURCE_TYPE == TIME_SOURCE_TYPE_DS3231 \
@@ -226,6 +253,15 @@ void setupDht22() {
 
 #if DISPLAY_TYPE == DISPLAY_TYPE_OLED
   SSD1306AsciiAceWire<WireInterface> oled(wireInterface);
+  #if ENABLE_DISPLAY_COUNTER
+    SSD1306AsciiCounter oledCounter(oled);
+    SSD1306Ascii& oledBus = oledCounter;
+  #else
+    SSD1306Ascii& oledBus = oled;
+  #endif
+  #if ENABLE_OLED_SHADOW
+    SSD1306AsciiShadow oledShadow(oledBus);
+  #endif
 
   void setupDisplay() {
     oled.begin(&Adafruit128x64, OLED_I2C_ADDRESS);
@@ -233,9 +269,21 @@ void setupDht22() {
     oled.setScrollMode(false);
     oled.clear();
     oled.setContrast(OLED_INITIAL_CONTRAST);
+  #if ENABLE_DISPLAY_COUNTER
+    oledCounter.begin(&Adafruit128x64);
+    oledCounter.setScrollMode(false);
+  #endif
+  #if ENABLE_OLED_SHADOW
+    oledShadow.begin(&Adafruit128x64);
+    oledShadow.setScrollMode(false);
+  #endif
   }
 #else
-  Adafruit_PCD8544 lcd = Adafruit_PCD8544(LCD_SPI_DATA_COMMAND_PIN, -1, -1);
+  #if ENABLE_LCD_SHADOW
+    PCD8544Shadow lcd(LCD_SPI_DATA_COMMAND_PIN, -1, -1);
+  #else
+    Adafruit_PCD8544 lcd = Adafruit_PCD8544(LCD_SPI_DATA_COMMAND_PIN, -1, -1);
+  #endif
 
   void setupDisplay() {
     lcd.begin();
@@ -244,8 +292,12 @@ void setupDht22() {
     lcd.setBias(LCD_INITIAL_BIAS);
 
     lcd.setTextWrap(false);
+  #if ENABLE_LCD_SHADOW
+    lcd.resetDisplay();
+  #else
     lcd.clearDisplay();
     lcd.display();
+  #endif
   }
 #endif
 
@@ -277,12 +329,16 @@ Presenter presenter(
   #if ENABLE_LED_DISPLAY
     ledModule,
   #endif
-  #if DISPLAY_TYPE == DISPLAY_TYPE_OLED
-    oled,
+  #if DISPLAY_TYPE == DISPLAY_TYPE_OLED && ENABLE_OLED_SHADOW
+    oledShadow,
+    true /*isOverwriting*/
+  #elif DISPLAY_TYPE == DISPLAY_TYPE_OLED
+    oledBus,
     true /*isOverwriting*/
   #else
     lcd,
-    false /*isOverwriting*/
+    // With the PCD8544Shadow, the text is drawn with an opaque background.
+    ENABLE_LCD_SHADOW /*isOverwriting*/
   #endif
 );
 
@@ -293,7 +349,8 @@ void setupPresenter() {
 // Create persistent store.
 //-----------------------------------------------------------------------------
 
-const uint32_t kContextId = 0xc42b2661; // random contextId
+// Random contextId, changed whenever the layout of the StoredInfo changes.
+const uint32_t kContextId = 0xe2c37f7c;
 const uint16_t kStoredInfoEepromAddress = 0;
 
 PersistentStore persistentStore(kContextId, kStoredInfoEepromAddress);
@@ -373,17 +430,19 @@ class RateMonitor {
 RateMonitor frameMonitor;
 #endif
 
-// The RTC has a resolution of only 1s, so we need to poll it fast enough to
-// make it appear that the display is tracking it correctly. The benchmarking
-// code says that controller.display() runs as fast as or faster than 1ms, so
-// we can set this to 100ms without worrying about too much overhead.
+// The RTC has a resolution of only 1s, so the display can change only when the
+// SystemClock rolls over to the next second, when the blinking state toggles,
+// or when a button is pressed. Instead of polling controller.update() every
+// 100ms, wait until controller.isUpdateDue() says that one of those has
+// happened. This calls update() about once a second, aligned with the
+// rollover of the SystemClock.
 COROUTINE(displayClock) {
   COROUTINE_LOOP() {
+    COROUTINE_AWAIT(controller.isUpdateDue());
     controller.update();
     #if ENABLE_FPS_DEBUG
       frameMonitor.sample();
     #endif
-    COROUTINE_DELAY(100);
   }
 }
 
@@ -391,8 +450,10 @@ COROUTINE(displayClock) {
 COROUTINE(printFrameRate) {
   COROUTINE_LOOP() {
     frameMonitor.reset();
+    controller.getPhaseEstimator().resetStats();
     COROUTINE_DELAY(5000);
     frameMonitor.printFrameRate();
+    controller.getPhaseEstimator().printStatsTo(Serial);
   }
 }
 #endif
@@ -578,6 +639,140 @@ void setupWire() {
   wireInterface.begin();
 }
 
+//-----------------------------------------------------------------------------
+// Benchmark the Controller and the Presenter in each Mode.
+//-----------------------------------------------------------------------------
+
+#if ENABLE_BENCHMARK
+
+static const uint16_t BENCHMARK_ITERATIONS = 100;
+
+// Stop if the Mode button never cycles back to the first Mode.
+static const uint8_t BENCHMARK_MAX_MODES = 64;
+
+// Start of the clock in each Mode.
+static acetime_t benchmarkStartSeconds;
+
+// Set if the steady-state display traffic exceeds its budget.
+static bool benchmarkOverBudget = false;
+
+// Highest steady-state display traffic of the view Modes, in bytes per second.
+static uint32_t benchmarkMaxViewBytesPerSecond = 0;
+
+// Print the display traffic per second after the first iteration, and check
+// it against the DISPLAY_BYTES_PER_SECOND_BUDGET.
+void printBenchmarkTraffic(uint8_t mode, uint32_t frameBytes,
+    bool checkBudget) {
+  uint16_t seconds = BENCHMARK_ITERATIONS - 1;
+#if DISPLAY_TYPE == DISPLAY_TYPE_OLED && ENABLE_DISPLAY_COUNTER
+  (void) frameBytes;
+  const SSD1306AsciiCounter::Traffic& traffic = oledCounter.traffic();
+  uint32_t bytes = traffic.bytes;
+  BenchmarkTimer::printLineTo(SERIAL_PORT_MONITOR, F("OneZoneClock"), mode,
+      F("busTransactionsPerSecond"), seconds, traffic.transactions / seconds);
+  BenchmarkTimer::printLineTo(SERIAL_PORT_MONITOR, F("OneZoneClock"), mode,
+      F("busCursorMovesPerSecond"), seconds, traffic.cursorMoves / seconds);
+#else
+  uint32_t bytes = frameBytes;
+#endif
+  BenchmarkTimer::printLineTo(SERIAL_PORT_MONITOR, F("OneZoneClock"), mode,
+      F("busBytesPerSecond"), seconds, bytes / seconds);
+  // Each second renders 2 frames, after the update and after the blink.
+  BenchmarkTimer::printLineTo(SERIAL_PORT_MONITOR, F("OneZoneClock"), mode,
+      F("busBytesPerFrame"), 2 * seconds, bytes / (2 * seconds));
+
+  if (checkBudget) {
+    uint32_t bytesPerSecond = bytes / seconds;
+    if (bytesPerSecond > benchmarkMaxViewBytesPerSecond) {
+      benchmarkMaxViewBytesPerSecond = bytesPerSecond;
+    }
+    if (bytesPerSecond > DISPLAY_BYTES_PER_SECOND_BUDGET) {
+      benchmarkOverBudget = true;
+    }
+  }
+}
+
+// Time each operation BENCHMARK_ITERATIONS times in the current Mode, with the
+// SystemClock advanced by 1 second before each iteration.
+// The update is the Controller alone, and each render is timed by
+// updateDisplay, after both the update and the blink.
+void benchmarkMode(bool isViewMode) {
+  BenchmarkTimer updateTimer;
+  BenchmarkTimer blinkTimer;
+  BenchmarkTimer displayTimer;
+  uint32_t frameBytes = 0;
+
+  for (uint16_t i = 0; i < BENCHMARK_ITERATIONS; ++i) {
+    systemClock.setNow(benchmarkStartSeconds + i);
+    updateTimer.start();
+    controller.updateClockInfo();
+    updateTimer.stop();
+    displayTimer.start();
+    presenter.updateDisplay();
+    displayTimer.stop();
+    frameBytes += presenter.getFrameBytes();
+    blinkTimer.start();
+    controller.updateBlinkState();
+    blinkTimer.stop();
+    displayTimer.start();
+    presenter.updateDisplay();
+    displayTimer.stop();
+    frameBytes += presenter.getFrameBytes();
+
+    // The first iteration redraws the whole screen of the new Mode.
+    if (i == 0) {
+      frameBytes = 0;
+    #if DISPLAY_TYPE == DISPLAY_TYPE_OLED && ENABLE_DISPLAY_COUNTER
+      oledCounter.resetTraffic();
+    #endif
+    }
+  }
+
+  uint8_t mode = (uint8_t) controller.getMode();
+  updateTimer.printTo(
+      SERIAL_PORT_MONITOR, F("OneZoneClock"), mode, F("update"));
+  blinkTimer.printTo(
+      SERIAL_PORT_MONITOR, F("OneZoneClock"), mode, F("updateBlinkState"));
+  displayTimer.printTo(
+      SERIAL_PORT_MONITOR, F("OneZoneClock"), mode, F("updateDisplay"));
+  printBenchmarkTraffic(mode, frameBytes, isViewMode);
+}
+
+// Benchmark each Mode, then restore the clock and the StoredInfo changed by
+// the walk through the Modes.
+void runBenchmark() {
+  benchmarkStartSeconds =
+      LocalDateTime::forComponents(2025, 1, 1, 0, 0, 0).toEpochSeconds();
+  acetime_t savedSeconds = systemClock.getNow();
+  uint32_t savedMillis = millis();
+  BenchmarkTimer::printHeaderTo(SERIAL_PORT_MONITOR);
+
+  benchmarkModes(controller, benchmarkMode, BENCHMARK_MAX_MODES);
+
+  // Restore the clock moved by the benchmark, and drop the StoredInfo saved
+  // when leaving each change Mode.
+  persistentStore.discard();
+  if (savedSeconds != LocalDateTime::kInvalidEpochSeconds) {
+    systemClock.setNow(savedSeconds + (millis() - savedMillis) / 1000);
+  }
+
+  SERIAL_PORT_MONITOR.print(F("# Max view Mode busBytesPerSecond: "));
+  SERIAL_PORT_MONITOR.print(benchmarkMaxViewBytesPerSecond);
+  SERIAL_PORT_MONITOR.print(F("; DISPLAY_BYTES_PER_SECOND_BUDGET: "));
+  SERIAL_PORT_MONITOR.println(DISPLAY_BYTES_PER_SECOND_BUDGET);
+  if (benchmarkOverBudget) {
+    SERIAL_PORT_MONITOR.println(
+        F("# Warning: display traffic exceeds "
+          "DISPLAY_BYTES_PER_SECOND_BUDGET"));
+  }
+
+#if defined(EPOXY_DUINO)
+  exit(0);
+#endif
+}
+
+#endif
+
 //------------------------------------------------------------------
 // Main setup and loop
 //------------------------------------------------------------------
@@ -594,7 +789,8 @@ void setup() {
   TXLED0; // LED off
 #endif
 
-if (ENABLE_SERIAL_DEBUG >= 1 || ENABLE_FPS_DEBUG >= 1) {
+if (ENABLE_SERIAL_DEBUG >= 1 || ENABLE_FPS_DEBUG >= 1
+    || ENABLE_BENCHMARK >= 1) {
   SERIAL_PORT_MONITOR.begin(115200);
   while (!SERIAL_PORT_MONITOR); // Leonardo/Micro
 }
@@ -630,6 +826,10 @@ if (ENABLE_SERIAL_DEBUG >= 1) {
   bool isModePressedDuringBoot = modeButton.isPressedRaw();
   setupController(isModePressedDuringBoot);
 
+#if ENABLE_BENCHMARK
+  runBenchmark();
+#endif
+
   if (ENABLE_SERIAL_DEBUG >= 1) {
     SERIAL_PORT_MONITOR.println(F("setup(): end"));
   }
@@ -644,6 +844,7 @@ void loop() {
 #endif
 
   displayClock.runCoroutine();
+  persistentStore.loop();
 
 #if ENABLE_FPS_DEBUG
   printFrameRate.runCoroutine();
@@ -654,4 +855,8 @@ void loop() {
 #else
   systemClock.runCoroutine();
 #endif
+
+#if ENABLE_SYNC_POLICY
+  syncPolicy.loop();
+#endif
 }
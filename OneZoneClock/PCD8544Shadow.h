@@ -0,0 +1,110 @@
+#ifndef ONE_ZONE_CLOCK_PCD8544_SHADOW_H
+#define ONE_ZONE_CLOCK_PCD8544_SHADOW_H
+
+#include <string.h> // memset()
+#include <Adafruit_PCD8544.h>
+
+/**
+ * A subclass of Adafruit_PCD8544 which tracks the dirty columns of each bank
+ * (row of 8 pixels) of the 84x48 LCD, so that flush() sends only the changed
+ * windows over SPI, instead of the entire 504-byte buffer.
+ *
+ * All Adafruit_GFX drawing goes through drawPixel(), which is overridden to
+ * draw into a shadow image. Only a pixel which actually changes extends the
+ * dirty column span of its bank. Then flush() sends each dirty span directly
+ * to the LCD, as a set-Y and a set-X command followed by the data bytes of the
+ * span, which the PCD8544 writes with its auto-incrementing X address. The
+ * buffer of the Adafruit_PCD8544 is used only by resetDisplay().
+ *
+ * The text must be drawn with an opaque background (setTextColor(BLACK,
+ * WHITE)) so that a character overwrites the previous one. Otherwise the
+ * screen must be cleared before each frame, which defeats the purpose.
+ * Display rotation is not supported.
+ */
+class PCD8544Shadow : public Adafruit_PCD8544 {
+  public:
+    static uint8_t const kNumBanks = LCDHEIGHT / 8;
+    static uint8_t const kNumColumns = LCDWIDTH;
+
+    /** Constructor. Same as the hardware SPI Adafruit_PCD8544. */
+    PCD8544Shadow(int8_t dcPin, int8_t csPin, int8_t rstPin) :
+        Adafruit_PCD8544(dcPin, csPin, rstPin) {
+      memset(mImage, 0, sizeof(mImage));
+      resetDirtySpans();
+    }
+
+    /**
+     * Clear the real display and the shadow image. Sends the full buffer, so
+     * this should be called only once after begin().
+     */
+    void resetDisplay() {
+      Adafruit_PCD8544::clearDisplay();
+      Adafruit_PCD8544::display();
+      memset(mImage, 0, sizeof(mImage));
+      resetDirtySpans();
+    }
+
+    /** Clear the shadow image. Only the lit pixels become dirty. */
+    void clearDisplay() {
+      fillScreen(WHITE);
+    }
+
+    /**
+     * Send the dirty column span of each bank to the LCD. Returns the number
+     * of bytes sent.
+     */
+    uint16_t flush() {
+      uint16_t bytes = 0;
+      for (uint8_t bank = 0; bank < kNumBanks; ++bank) {
+        uint8_t start = mDirtyStart[bank];
+        uint8_t end = mDirtyEnd[bank];
+        if (start >= end) continue;
+
+        command(PCD8544_SETYADDR | bank);
+        command(PCD8544_SETXADDR | start);
+        for (uint8_t x = start; x < end; ++x) {
+          data(mImage[bank][x]);
+        }
+        bytes += kWindowCommandBytes + (end - start);
+      }
+      resetDirtySpans();
+
+      mBytesSent += bytes;
+      return bytes;
+    }
+
+    /** Number of bytes (commands and data) sent to the LCD by flush(). */
+    uint32_t getBytesSent() const { return mBytesSent; }
+
+    void drawPixel(int16_t x, int16_t y, uint16_t color) override {
+      if (x < 0 || x >= kNumColumns || y < 0 || y >= kNumBanks * 8) return;
+
+      uint8_t bank = y >> 3;
+      uint8_t mask = 1 << (y & 0x7);
+      uint8_t& data = mImage[bank][x];
+      uint8_t newData = color ? (data | mask) : (data & ~mask);
+      if (newData == data) return;
+
+      data = newData;
+      if (x < mDirtyStart[bank]) mDirtyStart[bank] = x;
+      if (x >= mDirtyEnd[bank]) mDirtyEnd[bank] = x + 1;
+    }
+
+  private:
+    /** Set Y address and set X address. */
+    static uint8_t const kWindowCommandBytes = 2;
+
+    void resetDirtySpans() {
+      for (uint8_t bank = 0; bank < kNumBanks; ++bank) {
+        mDirtyStart[bank] = kNumColumns;
+        mDirtyEnd[bank] = 0;
+      }
+    }
+
+    uint8_t mImage[kNumBanks][kNumColumns];
+    uint8_t mDirtyStart[kNumBanks];
+    uint8_t mDirtyEnd[kNumBanks];
+    uint32_t mBytesSent = 0;
+};
+
+#endif
@@ -9,8 +9,14 @@
 #include <AceTime.h>
 #if DISPLAY_TYPE == DISPLAY_TYPE_LCD
   #include <Adafruit_PCD8544.h>
+  #if ENABLE_LCD_SHADOW
+    #include "PCD8544Shadow.h"
+  #endif
 #else
   #include <SSD1306AsciiWire.h>
+  #if ENABLE_OLED_SHADOW
+    #include "SSD1306AsciiShadow.h"
+  #endif
 #endif
 #if ENABLE_LED_DISPLAY
   #include <AceTMI.h>
@@ -52,6 +58,11 @@ using ace_common::printPad2To;
  * rendering each frame. Normally, this would cause a flicker in the display.
  * However, it seems like the LCD pixels have so much latency that I don't see
  * any flickering at all. It works, so I'll just keep it like that for now.
+ *
+ * If ENABLE_LCD_SHADOW is enabled, the LCD is a PCD8544Shadow instead. The
+ * text is drawn with an opaque background, so the LCD becomes an overwriting
+ * display and is cleared only on a mode change. Then renderDisplay() sends
+ * only the changed columns of each bank, instead of the whole 504-byte buffer.
  */
 class Presenter {
   public:
@@ -73,8 +84,12 @@ class Presenter {
       #if ENABLE_LED_DISPLAY
         LedDisplay& ledModule,
       #endif
-      #if DISPLAY_TYPE == DISPLAY_TYPE_LCD
+      #if DISPLAY_TYPE == DISPLAY_TYPE_LCD && ENABLE_LCD_SHADOW
+        PCD8544Shadow& display,
+      #elif DISPLAY_TYPE == DISPLAY_TYPE_LCD
         Adafruit_PCD8544& display,
+      #elif ENABLE_OLED_SHADOW
+        SSD1306AsciiShadow& display,
       #else
         SSD1306Ascii& display,
       #endif
@@ -89,6 +104,7 @@ class Presenter {
       {}
 
     void updateDisplay() {
+      mFrameBytes = 0;
       if (needsClear()) {
         clearDisplay();
       }
@@ -108,6 +124,12 @@ class Presenter {
       mClockInfo = clockInfo;
     }
 
+    /**
+     * Number of bytes sent to the LCD or OLED by the last updateDisplay().
+     * Not tracked (always 0) for the unbuffered OLED.
+     */
+    uint16_t getFrameBytes() const { return mFrameBytes; }
+
   private:
     // Disable copy-constructor and assignment operator
     Presenter(const Presenter&) = delete;
@@ -133,8 +155,15 @@ class Presenter {
     }
 
     void renderDisplay() {
-    #if DISPLAY_TYPE == DISPLAY_TYPE_LCD
+    #if DISPLAY_TYPE == DISPLAY_TYPE_LCD && ENABLE_LCD_SHADOW
+      // Send only the columns of each bank which changed since the last frame.
+      mFrameBytes = mDisplay.flush();
+    #elif DISPLAY_TYPE == DISPLAY_TYPE_LCD
       mDisplay.display();
+      mFrameBytes = kLcdFrameBytes;
+    #elif ENABLE_OLED_SHADOW
+      // Send only the column spans which changed since the last frame.
+      mFrameBytes = mDisplay.flush();
     #else
       // OLED display updates immediately upon println(), no need to call
       // anything else.
@@ -150,7 +179,9 @@ class Presenter {
      */
     void setFont(uint8_t size) {
     #if DISPLAY_TYPE == DISPLAY_TYPE_LCD
-      // Use default font
+      // Use default font, with an opaque background so that a character
+      // overwrites the previous one.
+      mDisplay.setTextColor(BLACK, WHITE);
       // if (size == 0) {
       //   mDisplay.setTextSize(8);
       // }
@@ -170,8 +201,12 @@ class Presenter {
 
     void clearToEOL() {
     #if DISPLAY_TYPE == DISPLAY_TYPE_LCD
-      // Not available, and not needed since the entire screen is clear
-      // on re-render.
+      int16_t x = mDisplay.getCursorX();
+      if (x < mDisplay.width()) {
+        mDisplay.fillRect(x, mDisplay.getCursorY(), mDisplay.width() - x,
+            8 /*height of default font*/, WHITE);
+      }
+      mDisplay.println();
     #else
       mDisplay.clearToEOL();
       mDisplay.println();
@@ -524,24 +559,21 @@ class Presenter {
     #if DISPLAY_TYPE == DISPLAY_TYPE_LCD
       mDisplay.print(F("Backlight:"));
       if (shouldShowFor(Mode::kChangeSettingsBacklight)) {
-        mDisplay.println(clockInfo.backlightLevel);
-      } else {
-        clearToEOL();
+        mDisplay.print(clockInfo.backlightLevel);
       }
+      clearToEOL();
 
       mDisplay.print(F("Contrast:"));
       if (shouldShowFor(Mode::kChangeSettingsContrast)) {
-        mDisplay.println(clockInfo.contrast);
-      } else {
-        clearToEOL();
+        mDisplay.print(clockInfo.contrast);
       }
+      clearToEOL();
 
       mDisplay.print(F("Bias:"));
       if (shouldShowFor(Mode::kChangeSettingsBias)) {
-        mDisplay.println(clockInfo.bias);
-      } else {
-        clearToEOL();
+        mDisplay.print(clockInfo.bias);
       }
+      clearToEOL();
 
     #else
       mDisplay.print(F("Contrast:"));
@@ -688,6 +720,9 @@ class Presenter {
   private:
   #if DISPLAY_TYPE == DISPLAY_TYPE_LCD
     static const uint16_t kLcdBacklightValues[];
+
+    /** Number of bytes sent by a full display() of the 84x48 LCD. */
+    static uint16_t const kLcdFrameBytes = 504;
   #else
     static const uint8_t kOledContrastValues[];
   #endif
@@ -702,14 +737,19 @@ class Presenter {
   #if ENABLE_LED_DISPLAY
     LedDisplay& mLedModule;
   #endif
-  #if DISPLAY_TYPE == DISPLAY_TYPE_LCD
+  #if DISPLAY_TYPE == DISPLAY_TYPE_LCD && ENABLE_LCD_SHADOW
+    PCD8544Shadow& mDisplay;
+  #elif DISPLAY_TYPE == DISPLAY_TYPE_LCD
     Adafruit_PCD8544& mDisplay;
+  #elif ENABLE_OLED_SHADOW
+    SSD1306AsciiShadow& mDisplay;
   #else
     SSD1306Ascii& mDisplay;
   #endif
     ClockInfo mClockInfo;
     ClockInfo mPrevClockInfo;
     bool const mIsOverwriting;
+    uint16_t mFrameBytes = 0;
 };
 
 #endif
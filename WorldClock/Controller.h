@@ -9,7 +9,9 @@
 #include <crc_eeprom/crc_eeprom.h> // from AceUtils
 #include "StoredInfo.h"
 #include "PersistentStore.h"
+#include "PhaseEstimator.h"
 #include "Presenter.h"
+#include "ZoneBatch.h"
 
 using namespace ace_time;
 using namespace ace_time::clock;
@@ -23,6 +25,8 @@ using ace_common::incrementMod;
  */
 class Controller {
   public:
+    static uint8_t const kNumZones = 3;
+
     /**
      * Constructor.
      * @param clock source of the current time
@@ -67,6 +71,9 @@ class Controller {
       updateDateTime();
     }
 
+    /** Return the current Mode, used by the benchmark. */
+    Mode getMode() const { return mClockInfo0.mode; }
+
     /**
      * In other Controller::update() methods, this method not only updates
      * the ClockInfo, but also synchronously calls the mPresenter.display(),
@@ -87,10 +94,37 @@ class Controller {
      */
     void update() {
       if (mClockInfo0.mode == Mode::kUnknown) return;
+      mUpdateRequested = false;
+      mLastUpdateMillis = millis();
       updateDateTime();
       updatePresenter();
     }
 
+    /**
+     * Return true if update() and the displayPresenterN() should be called.
+     * The ClockInfo can change only when the clock rolls over to the next
+     * second, when the blinking state toggles, or when a button is pressed.
+     * Between those events, this returns false using only millis(), so it can
+     * be polled on every iteration of loop().
+     *
+     * The PhaseEstimator predicts the rollover, and the clock is polled
+     * only from slightly ahead of it until its seconds change.
+     */
+    bool isUpdateDue() {
+      if (mUpdateRequested) return true;
+
+      uint16_t nowMillis = millis();
+      if ((uint16_t) (nowMillis - mLastUpdateMillis)
+          >= PhaseEstimator::kSecondMillis) {
+        return true;
+      }
+      if (mPhaseEstimator.isBeforeWindow(nowMillis)) return false;
+
+      if (mClock.getNow() != mPrevSeconds) return true;
+      mPhaseEstimator.observeOldSecond(nowMillis);
+      return false;
+    }
+
     void updateBlinkState () {
       mClockInfo0.blinkShowState = !mClockInfo0.blinkShowState;
       mClockInfo1.blinkShowState = !mClockInfo1.blinkShowState;
@@ -98,17 +132,30 @@ class Controller {
       mChangingClockInfo.blinkShowState = !mChangingClockInfo.blinkShowState;
 
       updatePresenter();
+
+      // The blinking state is rendered only by the Change modes and by the
+      // blinking colon of the date time.
+      if (mClockInfo0.mode >= Mode::kChangeYear
+          || (mClockInfo0.mode == Mode::kViewDateTime
+              && mClockInfo0.blinkingColon)) {
+        mUpdateRequested = true;
+      }
     }
 
     // These are exposed as public methods so that the
     // COROUTINE(updateController) can tell each Presenter to render to its OLED
     // dislay separately, interspersed with calls to COROUTINE_YIELD(). They
-    // should be called 5-10 times a second to support blinking mode and to
-    // avoid noticeable drift against the RTC which has a 1 second resolution.
+    // should be called after each update().
     void displayPresenter0() { mPresenter0.display(); }
     void displayPresenter1() { mPresenter1.display(); }
     void displayPresenter2() { mPresenter2.display(); }
 
+    /** Record the end of the rendering of all 3 displays. */
+    void recordRender() { mPhaseEstimator.recordRender(millis()); }
+
+    /** Estimator of the rollover of the clock, with its statistics. */
+    PhaseEstimator& getPhaseEstimator() { return mPhaseEstimator; }
+
     void handleModeButtonPress() {
       if (ENABLE_SERIAL_DEBUG >= 1) {
         SERIAL_PORT_MONITOR.println(F("handleModeButtonPress()"));
@@ -169,6 +216,7 @@ class Controller {
       mChangingClockInfo.mode = mClockInfo0.mode;
       mClockInfo1.mode = mClockInfo0.mode;
       mClockInfo2.mode = mClockInfo0.mode;
+      mUpdateRequested = true;
     }
 
     /** Toggle edit mode. The editable field will start blinking. */
@@ -217,6 +265,7 @@ class Controller {
       mChangingClockInfo.mode = mClockInfo0.mode;
       mClockInfo1.mode = mClockInfo0.mode;
       mClockInfo2.mode = mClockInfo0.mode;
+      mUpdateRequested = true;
     }
 
     /**
@@ -248,6 +297,8 @@ class Controller {
         default:
           break;
       }
+
+      mUpdateRequested = true;
     }
 
     /**
@@ -342,6 +393,7 @@ class Controller {
           mClockInfo1.suppressBlink = false;
           mClockInfo2.suppressBlink = false;
           mChangingClockInfo.suppressBlink = false;
+          mUpdateRequested = true;
           break;
 
         default:
@@ -350,14 +402,26 @@ class Controller {
     }
 
   protected:
+    /** Feed the millis() of a new second of the clock to the PhaseEstimator. */
+    void trackRollover(acetime_t nowSeconds) {
+      if (nowSeconds == mPrevSeconds) return;
+
+      mPrevSeconds = nowSeconds;
+      mPhaseEstimator.observeRollover(mLastUpdateMillis);
+    }
+
     void updateDateTime() {
       acetime_t now = mClock.getNow();
-      mClockInfo0.dateTime = ZonedDateTime::forEpochSeconds(
-          now, mClockInfo0.timeZone);
-      mClockInfo1.dateTime = ZonedDateTime::forEpochSeconds(
-          now, mClockInfo1.timeZone);
-      mClockInfo2.dateTime = ZonedDateTime::forEpochSeconds(
-          now, mClockInfo2.timeZone);
+      trackRollover(now);
+      const TimeZone zones[kNumZones] = {
+        mClockInfo0.timeZone,
+        mClockInfo1.timeZone,
+        mClockInfo2.timeZone,
+      };
+      mZoneBatch.convert(now, zones);
+      mClockInfo0.dateTime = mZoneBatch.dateTime(0);
+      mClockInfo1.dateTime = mZoneBatch.dateTime(1);
+      mClockInfo2.dateTime = mZoneBatch.dateTime(2);
 
       // If in CHANGE mode, and the 'second' field has not been cleared,
       // update the mChangingClockInfo.second field with the current second.
@@ -480,7 +544,7 @@ class Controller {
     void preserveClockInfo() {
       StoredInfo storedInfo;
       storedInfoFromClockInfo(storedInfo);
-      mPersistentStore.writeStoredInfo(storedInfo);
+      mPersistentStore.saveStoredInfo(storedInfo);
     }
 
     /** Restore from EEPROM. If that fails, set initial states. */
@@ -580,6 +644,15 @@ class Controller {
     ClockInfo mClockInfo2;
     ClockInfo mChangingClockInfo;
     bool mSecondFieldCleared = false;
+
+    // Conversion of the current time into the 3 time zones.
+    ZoneBatch<kNumZones> mZoneBatch;
+
+    // State of the update scheduling in isUpdateDue().
+    PhaseEstimator mPhaseEstimator;
+    acetime_t mPrevSeconds = 0;
+    uint16_t mLastUpdateMillis = 0;
+    bool mUpdateRequested = true;
 };
 
 #endif
@@ -0,0 +1,124 @@
+#ifndef WORLD_CLOCK_PHASE_ESTIMATOR_H
+#define WORLD_CLOCK_PHASE_ESTIMATOR_H
+
+#include <Arduino.h> // Print
+
+/**
+ * Estimates the sub-second phase of the SystemClock, i.e. the millis() at
+ * which its seconds roll over, so that the Controller can wake up slightly
+ * ahead of the next rollover and render the new second as soon as it appears.
+ *
+ * The SystemClock has only 1-second resolution, so the rollover is measured by
+ * polling getNow() starting kLeadMillis before the predicted boundary. If the
+ * previous second was still seen inside that window (observeOldSecond()), the
+ * new second seen by observeRollover() brackets the boundary to within one
+ * iteration of loop(). The midpoint of the bracket corrects the prediction
+ * through a first-order filter which absorbs the jitter of the loop. A
+ * rollover which arrives before the window (e.g. after the SystemClock is
+ * synced), or which misses the prediction by more than kLockErrorMillis,
+ * unlocks the estimator until the next bracketed rollover.
+ *
+ * The phase error is the number of millis between the estimated boundary and
+ * the end of the render of the new second, as passed into recordRender(). Its
+ * average and maximum are accumulated until resetStats().
+ */
+class PhaseEstimator {
+  public:
+    static uint16_t const kSecondMillis = 1000;
+
+    /** Number of millis before the predicted boundary to start polling. */
+    static uint16_t const kLeadMillis = 20;
+
+    /** Maximum misprediction before the estimator unlocks. */
+    static int16_t const kLockErrorMillis = 50;
+
+    /**
+     * Return true if the next rollover cannot happen yet, so that the
+     * SystemClock does not need to be polled.
+     */
+    bool isBeforeWindow(uint16_t nowMillis) const {
+      return mIsLocked
+          && (uint16_t) (nowMillis - mBoundaryMillis)
+              < kSecondMillis - kLeadMillis;
+    }
+
+    /** The SystemClock still showed the previous second at nowMillis. */
+    void observeOldSecond(uint16_t nowMillis) {
+      mOldSecondMillis = nowMillis;
+      mIsOldSecondSeen = true;
+    }
+
+    /** The SystemClock was first seen to show the new second at nowMillis. */
+    void observeRollover(uint16_t nowMillis) {
+      if (! mIsOldSecondSeen) {
+        // The boundary is somewhere in the previous polling gap.
+        if (mIsLocked) mNumUnlocks++;
+        mIsLocked = false;
+        mBoundaryMillis = nowMillis;
+      } else {
+        uint16_t measured = mOldSecondMillis
+            + (uint16_t) (nowMillis - mOldSecondMillis) / 2;
+        uint16_t predicted = mBoundaryMillis + kSecondMillis;
+        int16_t error = (int16_t) (measured - predicted);
+        if (! mIsLocked) {
+          mIsLocked = true;
+          mBoundaryMillis = measured;
+        } else if (error > kLockErrorMillis || error < -kLockErrorMillis) {
+          mNumUnlocks++;
+          mBoundaryMillis = measured;
+        } else {
+          mBoundaryMillis = predicted + error / 2;
+        }
+      }
+
+      mIsOldSecondSeen = false;
+      mIsRenderPending = true;
+    }
+
+    /**
+     * The new second has been rendered at doneMillis. Ignored unless a
+     * rollover was observed since the last call.
+     */
+    void recordRender(uint16_t doneMillis) {
+      if (! mIsRenderPending) return;
+      mIsRenderPending = false;
+      if (! mIsLocked) return;
+
+      int16_t error = (int16_t) (doneMillis - mBoundaryMillis);
+      uint16_t absError = (error < 0) ? -error : error;
+      if (absError > mMaxError) mMaxError = absError;
+      mSumError += absError;
+      mNumSamples++;
+    }
+
+    /** Print the phase error statistics, e.g. "phase err ms: avg 2; max 5". */
+    void printStatsTo(Print& printer) const {
+      printer.print(F("phase err ms: avg "));
+      printer.print(mNumSamples ? mSumError / mNumSamples : 0);
+      printer.print(F("; max "));
+      printer.print(mMaxError);
+      printer.print(F("; unlocks "));
+      printer.println(mNumUnlocks);
+    }
+
+    void resetStats() {
+      mSumError = 0;
+      mNumSamples = 0;
+      mMaxError = 0;
+      mNumUnlocks = 0;
+    }
+
+  private:
+    uint32_t mSumError = 0;
+    uint16_t mNumSamples = 0;
+    uint16_t mMaxError = 0;
+    uint16_t mNumUnlocks = 0;
+
+    uint16_t mBoundaryMillis = 0;
+    uint16_t mOldSecondMillis = 0;
+    bool mIsLocked = false;
+    bool mIsOldSecondSeen = false;
+    bool mIsRenderPending = false;
+};
+
+#endif
@@ -5,6 +5,9 @@
 #include <AceTime.h>
 #include "ClockInfo.h"
 #include "config.h"
+#if ENABLE_OLED_SHADOW
+  #include "SSD1306AsciiShadow.h"
+#endif
 
 using namespace ace_time;
 using ace_common::printPad2To;
@@ -20,12 +23,17 @@ using ace_common::printPad2To;
 class Presenter {
   public:
     /** Constructor. */
+  #if ENABLE_OLED_SHADOW
+    Presenter(SSD1306AsciiShadow& oled):
+  #else
     Presenter(SSD1306Ascii& oled):
+  #endif
         mOled(oled) {}
 
     void display() {
       if (mClockInfo.mode == Mode::kUnknown) {
         clearDisplay();
+        flushDisplay();
         return;
       }
 
@@ -41,6 +49,7 @@ class Presenter {
         writeDisplaySettings();
         mPrevClockInfo = mClockInfo;
       }
+      flushDisplay();
     }
 
     /**
@@ -74,6 +83,13 @@ class Presenter {
 
     void clearDisplay() const { mOled.clear(); }
 
+    /** Send the buffered frame to the OLED, if ENABLE_OLED_SHADOW is on. */
+    void flushDisplay() const {
+    #if ENABLE_OLED_SHADOW
+      mOled.flush();
+    #endif
+    }
+
     void clearToEOL() const {
       mOled.clearToEOL();
       mOled.println();
@@ -350,7 +366,11 @@ class Presenter {
     static const uint8_t kNumContrastValues = 10;
     static const uint8_t kContrastValues[];
 
+  #if ENABLE_OLED_SHADOW
+    SSD1306AsciiShadow& mOled;
+  #else
     SSD1306Ascii& mOled;
+  #endif
 
     mutable ClockInfo mClockInfo;
     mutable ClockInfo mPrevClockInfo;
@@ -0,0 +1,162 @@
+#ifndef WORLD_CLOCK_SSD1306_ASCII_SHADOW_H
+#define WORLD_CLOCK_SSD1306_ASCII_SHADOW_H
+
+#include <string.h> // memset()
+#include <SSD1306Ascii.h>
+
+/**
+ * A 128x64 shadow page buffer which sits between the Presenter and the real
+ * SSD1306Ascii driver. The Presenter prints to this object exactly as it would
+ * to the real display, but the RAM bytes are written into the shadow buffer
+ * instead of being sent over the bus. A byte which differs from the buffer
+ * extends the dirty column span of its page. Then flush() sends only the dirty
+ * column span of each page to the real display.
+ *
+ * Commands which only move the RAM pointer of the controller (set column,
+ * set page) are dropped, since flush() positions the cursor of the real
+ * display itself. All other commands (contrast, invert, display on/off, etc)
+ * are forwarded to the real display immediately.
+ *
+ * The buffer takes 1 kB of RAM, which is too much for most AVR boards, so it
+ * is enabled by the ENABLE_OLED_SHADOW macro in config.h.
+ */
+class SSD1306AsciiShadow : public SSD1306Ascii {
+  public:
+    static uint8_t const kNumPages = 8;
+    static uint8_t const kNumColumns = 128;
+
+    /** Constructor. The real display must be initialized with its begin(). */
+    explicit SSD1306AsciiShadow(SSD1306Ascii& display) :
+        mDisplay(display) {
+      memset(mBuffer, 0, sizeof(mBuffer));
+      resetDirtySpans();
+    }
+
+    /**
+     * Initialize the shadow buffer for the given device. The initialization
+     * commands are not forwarded because the real display has already been
+     * initialized and cleared by its own begin().
+     */
+    void begin(const DevType* dev) {
+      mForwardCommands = false;
+      init(dev);
+      mForwardCommands = true;
+    }
+
+    /**
+     * Send the dirty column span of each page to the real display. Returns
+     * the number of bytes sent.
+     */
+    uint16_t flush() {
+      uint16_t bytes = 0;
+      for (uint8_t page = 0; page < kNumPages; ++page) {
+        uint8_t start = mDirtyStart[page];
+        uint8_t end = mDirtyEnd[page];
+        if (start >= end) continue;
+
+        // The real display buffers the RAM bytes until the last one.
+        mDisplay.setCursor(start, page);
+        const uint8_t* data = &mBuffer[page][start];
+        for (uint8_t col = start + 1; col < end; ++col) {
+          mDisplay.ssd1306WriteRamBuf(*data++);
+        }
+        mDisplay.ssd1306WriteRam(*data);
+        bytes += kCursorBytes + (end - start);
+      }
+      resetDirtySpans();
+
+      mBytesSent += bytes;
+      return bytes;
+    }
+
+    /** Number of bytes (commands and RAM) sent to the real display. */
+    uint32_t getBytesSent() const { return mBytesSent; }
+
+  protected:
+    void writeDisplay(uint8_t b, uint8_t mode) override {
+      if (mode == SSD1306_MODE_CMD) {
+        writeCommand(b);
+        return;
+      }
+
+      uint8_t page = row();
+      uint8_t column = col();
+      if (page >= kNumPages || column >= kNumColumns) return;
+      if (mBuffer[page][column] == b) return;
+
+      mBuffer[page][column] = b;
+      if (column < mDirtyStart[page]) mDirtyStart[page] = column;
+      if (column >= mDirtyEnd[page]) mDirtyEnd[page] = column + 1;
+    }
+
+  private:
+    /** Number of command bytes sent by setCursor() of the real display. */
+    static uint8_t const kCursorBytes = 3;
+
+    /** Forward the command byte to the real display, unless redundant. */
+    void writeCommand(uint8_t b) {
+      if (mPendingArgs > 0) {
+        // Arguments of a multi-byte command look like any other command.
+        mPendingArgs--;
+      } else {
+        mPendingArgs = numCommandArgs(b);
+        if (mPendingArgs == 0 && isAddressCommand(b)) return;
+      }
+
+      if (mForwardCommands) {
+        mDisplay.ssd1306WriteCmd(b);
+        mBytesSent++;
+      }
+    }
+
+    /** Set lower column, set higher column, or set page start address. */
+    static bool isAddressCommand(uint8_t c) {
+      return c < 0x20 || (c & 0xF8) == 0xB0;
+    }
+
+    /** Number of argument bytes following the given SSD1306 command. */
+    static uint8_t numCommandArgs(uint8_t c) {
+      switch (c) {
+        case 0x20: // memory addressing mode
+        case 0x81: // contrast
+        case 0x8D: // charge pump
+        case 0xA8: // multiplex ratio
+        case 0xAD: // DC-DC control (SH1106)
+        case 0xD3: // display offset
+        case 0xD5: // clock divide ratio
+        case 0xD9: // pre-charge period
+        case 0xDA: // COM pins configuration
+        case 0xDB: // VCOMH deselect level
+          return 1;
+        case 0x21: // column address
+        case 0x22: // page address
+        case 0xA3: // vertical scroll area
+          return 2;
+        case 0x29: // vertical and horizontal scroll
+        case 0x2A:
+          return 5;
+        case 0x26: // horizontal scroll
+        case 0x27:
+          return 6;
+        default:
+          return 0;
+      }
+    }
+
+    void resetDirtySpans() {
+      for (uint8_t page = 0; page < kNumPages; ++page) {
+        mDirtyStart[page] = kNumColumns;
+        mDirtyEnd[page] = 0;
+      }
+    }
+
+    SSD1306Ascii& mDisplay;
+    uint8_t mBuffer[kNumPages][kNumColumns];
+    uint8_t mDirtyStart[kNumPages];
+    uint8_t mDirtyEnd[kNumPages];
+    uint32_t mBytesSent = 0;
+    uint8_t mPendingArgs = 0;
+    bool mForwardCommands = true;
+};
+
+#endif
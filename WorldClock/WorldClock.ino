@@ -66,8 +66,10 @@
 #include <AceWire.h>
 #include <AceSPI.h>
 #include <SSD1306AsciiAceSpi.h>
+#include "SSD1306AsciiCounter.h"
 #include "ClockInfo.h"
 #include "Controller.h"
+#include "Benchmark.h"
 #include "PersistentStore.h"
 
 using namespace ace_button;
@@ -79,7 +81,8 @@ using namespace ace_spi;
 // Configure PersistentStore
 //----------------------------------------------------------------------------
 
-const uint32_t kContextId = 0x8f01000b; // random contextId
+// Random contextId, changed whenever the layout of the StoredInfo changes.
+const uint32_t kContextId = 0x829d41e9;
 const uint16_t kStoredInfoEepromAddress = 0;
 
 PersistentStore persistentStore(kContextId, kStoredInfoEepromAddress);
@@ -181,6 +184,25 @@ SystemClockCoroutine systemClock(&dsClock, &dsClock);
   #error Unknown OLED_INTERFACE_TYPE
 #endif
 
+#if ENABLE_DISPLAY_COUNTER
+  SSD1306AsciiCounter oledCounter0(oled0);
+  SSD1306AsciiCounter oledCounter1(oled1);
+  SSD1306AsciiCounter oledCounter2(oled2);
+  SSD1306Ascii& oledBus0 = oledCounter0;
+  SSD1306Ascii& oledBus1 = oledCounter1;
+  SSD1306Ascii& oledBus2 = oledCounter2;
+#else
+  SSD1306Ascii& oledBus0 = oled0;
+  SSD1306Ascii& oledBus1 = oled1;
+  SSD1306Ascii& oledBus2 = oled2;
+#endif
+
+#if ENABLE_OLED_SHADOW
+  SSD1306AsciiShadow oledShadow0(oledBus0);
+  SSD1306AsciiShadow oledShadow1(oledBus1);
+  SSD1306AsciiShadow oledShadow2(oledBus2);
+#endif
+
 void setupOled() {
   pinMode(OLED_CS0_PIN, OUTPUT);
   pinMode(OLED_CS1_PIN, OUTPUT);
@@ -210,15 +232,41 @@ void setupOled() {
   oled0.setScrollMode(false);
   oled1.setScrollMode(false);
   oled2.setScrollMode(false);
+
+#if ENABLE_DISPLAY_COUNTER
+  oledCounter0.begin(&Adafruit128x64);
+  oledCounter1.begin(&Adafruit128x64);
+  oledCounter2.begin(&Adafruit128x64);
+
+  oledCounter0.setScrollMode(false);
+  oledCounter1.setScrollMode(false);
+  oledCounter2.setScrollMode(false);
+#endif
+
+#if ENABLE_OLED_SHADOW
+  oledShadow0.begin(&Adafruit128x64);
+  oledShadow1.begin(&Adafruit128x64);
+  oledShadow2.begin(&Adafruit128x64);
+
+  oledShadow0.setScrollMode(false);
+  oledShadow1.setScrollMode(false);
+  oledShadow2.setScrollMode(false);
+#endif
 }
 
 //----------------------------------------------------------------------------
 // Create 3 Presenters for 3 OLED displays
 //----------------------------------------------------------------------------
 
-Presenter presenter0(oled0);
-Presenter presenter1(oled1);
-Presenter presenter2(oled2);
+#if ENABLE_OLED_SHADOW
+  Presenter presenter0(oledShadow0);
+  Presenter presenter1(oledShadow1);
+  Presenter presenter2(oledShadow2);
+#else
+  Presenter presenter0(oledBus0);
+  Presenter presenter1(oledBus1);
+  Presenter presenter2(oledBus2);
+#endif
 
 //----------------------------------------------------------------------------
 // Setup time zones.
@@ -259,12 +307,14 @@ Controller controller(
     "SFO", "PHL", "LHR"
 );
 
-// The RTC has a resolution of only 1s, so we need to poll it fast enough to
-// make it appear that the display is tracking it correctly. The benchmarking
-// code says that controller.update() runs faster than 1ms so we can set this
-// to 100ms without worrying about too much overhead.
+// The RTC has a resolution of only 1s, so the displays can change only when
+// the clock rolls over to the next second, when the blinking state toggles, or
+// when a button is pressed. Instead of polling controller.update() every
+// 100ms, wait until controller.isUpdateDue() says that one of those has
+// happened.
 COROUTINE(updateController) {
   COROUTINE_LOOP() {
+    COROUTINE_AWAIT(controller.isUpdateDue());
     controller.update();
 
     COROUTINE_YIELD();
@@ -275,10 +325,21 @@ COROUTINE(updateController) {
 
     COROUTINE_YIELD();
     controller.displayPresenter2();
+    controller.recordRender();
+  }
+}
 
-    COROUTINE_DELAY(100);
+#if ENABLE_SERIAL_DEBUG >= 1
+// Print the phase error between the rollover of the clock and the end of the
+// rendering of the new second.
+COROUTINE(printPhaseStats) {
+  COROUTINE_LOOP() {
+    controller.getPhaseEstimator().resetStats();
+    COROUTINE_DELAY(5000);
+    controller.getPhaseEstimator().printStatsTo(SERIAL_PORT_MONITOR);
   }
 }
+#endif
 
 COROUTINE(blinker) {
   COROUTINE_LOOP() {
@@ -415,6 +476,139 @@ void setupSPI() {
 #endif
 }
 
+//-----------------------------------------------------------------------------
+// Benchmark the Controller and the Presenter in each Mode.
+//-----------------------------------------------------------------------------
+
+#if ENABLE_BENCHMARK
+
+static const uint16_t BENCHMARK_ITERATIONS = 100;
+
+// Stop if the Mode button never cycles back to the first Mode.
+static const uint8_t BENCHMARK_MAX_MODES = 64;
+
+// Start of the clock in each Mode.
+static acetime_t benchmarkStartSeconds;
+
+// Set if the steady-state display traffic exceeds its budget.
+static bool benchmarkOverBudget = false;
+
+// Highest steady-state display traffic of the view Modes, in bytes per second.
+static uint32_t benchmarkMaxViewBytesPerSecond = 0;
+
+#if ENABLE_DISPLAY_COUNTER
+// Print the traffic per second to the 3 OLEDs after the first iteration, and
+// check it against the DISPLAY_BYTES_PER_SECOND_BUDGET.
+void printBenchmarkTraffic(uint8_t mode, bool checkBudget) {
+  uint16_t seconds = BENCHMARK_ITERATIONS - 1;
+  const SSD1306AsciiCounter::Traffic& traffic0 = oledCounter0.traffic();
+  const SSD1306AsciiCounter::Traffic& traffic1 = oledCounter1.traffic();
+  const SSD1306AsciiCounter::Traffic& traffic2 = oledCounter2.traffic();
+  uint32_t bytes = traffic0.bytes + traffic1.bytes + traffic2.bytes;
+  uint32_t transactions = traffic0.transactions + traffic1.transactions
+      + traffic2.transactions;
+  uint32_t cursorMoves = traffic0.cursorMoves + traffic1.cursorMoves
+      + traffic2.cursorMoves;
+
+  BenchmarkTimer::printLineTo(SERIAL_PORT_MONITOR, F("WorldClock"), mode,
+      F("busTransactionsPerSecond"), seconds, transactions / seconds);
+  BenchmarkTimer::printLineTo(SERIAL_PORT_MONITOR, F("WorldClock"), mode,
+      F("busCursorMovesPerSecond"), seconds, cursorMoves / seconds);
+  BenchmarkTimer::printLineTo(SERIAL_PORT_MONITOR, F("WorldClock"), mode,
+      F("busBytesPerSecond"), seconds, bytes / seconds);
+
+  if (checkBudget) {
+    uint32_t bytesPerSecond = bytes / seconds;
+    if (bytesPerSecond > benchmarkMaxViewBytesPerSecond) {
+      benchmarkMaxViewBytesPerSecond = bytesPerSecond;
+    }
+    if (bytesPerSecond > DISPLAY_BYTES_PER_SECOND_BUDGET) {
+      benchmarkOverBudget = true;
+    }
+  }
+}
+#endif
+
+// Time each operation BENCHMARK_ITERATIONS times in the current Mode, with the
+// SystemClock advanced by 1 second before each iteration.
+void benchmarkMode(bool isViewMode) {
+  BenchmarkTimer updateTimer;
+  BenchmarkTimer blinkTimer;
+  BenchmarkTimer displayTimer;
+
+  for (uint16_t i = 0; i < BENCHMARK_ITERATIONS; ++i) {
+    systemClock.setNow(benchmarkStartSeconds + i);
+    updateTimer.start();
+    controller.update();
+    updateTimer.stop();
+    blinkTimer.start();
+    controller.updateBlinkState();
+    blinkTimer.stop();
+    displayTimer.start();
+    controller.displayPresenter0();
+    controller.displayPresenter1();
+    controller.displayPresenter2();
+    displayTimer.stop();
+
+  #if ENABLE_DISPLAY_COUNTER
+    // The first iteration redraws the whole screen of the new Mode.
+    if (i == 0) {
+      oledCounter0.resetTraffic();
+      oledCounter1.resetTraffic();
+      oledCounter2.resetTraffic();
+    }
+  #endif
+  }
+
+  uint8_t mode = (uint8_t) controller.getMode();
+  updateTimer.printTo(
+      SERIAL_PORT_MONITOR, F("WorldClock"), mode, F("update"));
+  blinkTimer.printTo(
+      SERIAL_PORT_MONITOR, F("WorldClock"), mode, F("updateBlinkState"));
+  displayTimer.printTo(
+      SERIAL_PORT_MONITOR, F("WorldClock"), mode, F("updateDisplay"));
+#if ENABLE_DISPLAY_COUNTER
+  printBenchmarkTraffic(mode, isViewMode);
+#else
+  (void) isViewMode;
+#endif
+}
+
+// Benchmark each Mode, then restore the clock and the StoredInfo changed by
+// the walk through the Modes.
+void runBenchmark() {
+  benchmarkStartSeconds =
+      LocalDateTime::forComponents(2025, 1, 1, 0, 0, 0).toEpochSeconds();
+  acetime_t savedSeconds = systemClock.getNow();
+  uint32_t savedMillis = millis();
+  BenchmarkTimer::printHeaderTo(SERIAL_PORT_MONITOR);
+
+  benchmarkModes(controller, benchmarkMode, BENCHMARK_MAX_MODES);
+
+  // Restore the clock moved by the benchmark, and drop the StoredInfo saved
+  // when leaving each change Mode.
+  persistentStore.discard();
+  if (savedSeconds != LocalDateTime::kInvalidEpochSeconds) {
+    systemClock.setNow(savedSeconds + (millis() - savedMillis) / 1000);
+  }
+
+  SERIAL_PORT_MONITOR.print(F("# Max view Mode busBytesPerSecond: "));
+  SERIAL_PORT_MONITOR.print(benchmarkMaxViewBytesPerSecond);
+  SERIAL_PORT_MONITOR.print(F("; DISPLAY_BYTES_PER_SECOND_BUDGET: "));
+  SERIAL_PORT_MONITOR.println(DISPLAY_BYTES_PER_SECOND_BUDGET);
+  if (benchmarkOverBudget) {
+    SERIAL_PORT_MONITOR.println(
+        F("# Warning: display traffic exceeds "
+          "DISPLAY_BYTES_PER_SECOND_BUDGET"));
+  }
+
+#if defined(EPOXY_DUINO)
+  exit(0);
+#endif
+}
+
+#endif
+
 //----------------------------------------------------------------------------
 // Main setup and loop
 //----------------------------------------------------------------------------
@@ -431,9 +625,11 @@ void setup() {
   TXLED0; // LED off
 #endif
 
-  if (ENABLE_SERIAL_DEBUG >= 1) {
+  if (ENABLE_SERIAL_DEBUG >= 1 || ENABLE_BENCHMARK >= 1) {
     SERIAL_PORT_MONITOR.begin(115200);
     while (!SERIAL_PORT_MONITOR); // Leonardo/Micro
+  }
+  if (ENABLE_SERIAL_DEBUG >= 1) {
     SERIAL_PORT_MONITOR.println(F("setup(): begin"));
   }
 
@@ -450,6 +646,10 @@ void setup() {
   bool isModePressedDuringBoot = modeButton.isPressedRaw();
   controller.setup(isModePressedDuringBoot);
 
+#if ENABLE_BENCHMARK
+  runBenchmark();
+#endif
+
   if (ENABLE_SERIAL_DEBUG >= 1) {
     SERIAL_PORT_MONITOR.println(F("setup(): end"));
   }
@@ -461,7 +661,11 @@ void loop() {
   // call CoroutineScheduler::loop();
   updateController.runCoroutine();
   blinker.runCoroutine();
+#if ENABLE_SERIAL_DEBUG >= 1
+  printPhaseStats.runCoroutine();
+#endif
   systemClock.runCoroutine();
+  persistentStore.loop();
 
   // Call AceButton::check directly instead of using COROUTINE() to save 174
   // bytes in flash memory, and 31 bytes in static memory.
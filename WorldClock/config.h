@@ -13,9 +13,59 @@
 #define ENABLE_SERIAL_DEBUG 0
 #endif
 
+// Set to 1 to benchmark the Controller and Presenter in each Mode at the end
+// of setup(), printing CSV lines to SERIAL_PORT_MONITOR. On EpoxyDuino, run
+// `make benchmark`, which exits after the benchmark.
+#ifndef ENABLE_BENCHMARK
+#define ENABLE_BENCHMARK 0
+#endif
+
+// Set to 1 to render the OLED through the 1 kB SSD1306AsciiShadow page buffer,
+// which sends only the changed column spans to the display. Too much RAM for
+// most AVR boards.
+#ifndef ENABLE_OLED_SHADOW
+  #if defined(ARDUINO_ARCH_AVR)
+    #define ENABLE_OLED_SHADOW 0
+  #else
+    #define ENABLE_OLED_SHADOW 1
+  #endif
+#endif
+
+// Set to 1 to count the bytes, bus transactions and cursor moves sent to each
+// OLED, by placing an SSD1306AsciiCounter in front of it.
+#ifndef ENABLE_DISPLAY_COUNTER
+#define ENABLE_DISPLAY_COUNTER 0
+#endif
+
+// Steady-state display traffic budget, in bytes per second summed over the 3
+// OLEDs, of each view Mode. The traffic is measured only if
+// ENABLE_DISPLAY_COUNTER is set.
+// These values are provisional estimates, not yet recorded from a run, so
+// `make benchmark` only prints a warning when the traffic exceeds them, and
+// does not fail. Record the budget from the "Max view Mode busBytesPerSecond"
+// line of the benchmark plus a margin, before making it fail the benchmark.
+#ifndef DISPLAY_BYTES_PER_SECOND_BUDGET
+#define DISPLAY_BYTES_PER_SECOND_BUDGET 1536
+#endif
+
 // PersistentStore
 #define ENABLE_EEPROM 1
 
+// Number of StoredInfo slots in the EEPROM, written in rotation so that each
+// save wears a different slot, and a torn save leaves the previous slot intact.
+// At least 2. The flash-emulated EEPROM of the ESP8266, ESP32 and STM32
+// rewrites its whole buffer on each commit, so more slots do not reduce wear.
+// All the slots also live in that one flash sector, which is erased and
+// rewritten by the commit, so a power loss during a commit can lose every
+// slot. The torn save guarantee holds only on the AVR (and EpoxyDuino).
+#ifndef NUM_STORED_INFO_SLOTS
+  #if defined(ARDUINO_ARCH_AVR) || defined(EPOXY_DUINO)
+    #define NUM_STORED_INFO_SLOTS 8
+  #else
+    #define NUM_STORED_INFO_SLOTS 2
+  #endif
+#endif
+
 // Set to 1 to factory reset.
 #define FORCE_INITIALIZE 0
 